@@ -0,0 +1,316 @@
+#!/usr/bin/env python3
+"""
+CPU Scheduler Benchmark Suite
+=============================
+
+This module measures how the scheduler scales with workload size. It:
+
+1. Generates synthetic workloads (Poisson arrivals, exponential or
+   heavy-tailed bursts, a weighted priority mix) from a fixed seed
+2. Runs every algorithm over a grid of process counts and CPU counts
+3. Reports wall time, ns per simulated tick, ns per event and peak RSS
+4. Optionally compares against a saved CSV and fails on regressions
+
+An "event" here is a process arrival or completion inside the simulated
+horizon, so ns/event stays comparable when the clock skips idle time.
+
+Usage:
+    python bench_scheduler.py [options]            Run the suite
+    python bench_scheduler.py gen -n N [options]   Print one workload
+
+Options:
+    --executable PATH    Path to the scheduler executable
+    --sizes LIST         Process counts, e.g. 1000,10000 (default 1e3..1e6)
+    --cpus LIST          CPU counts (default 1,4,16,64)
+    --algorithms LIST    Algorithms to run (default: all seven)
+    --quick              Small grid for a fast smoke run
+    --csv FILE           Also write the results as CSV
+    --compare FILE       Fail if wall time regressed against this CSV
+    --tolerance FRAC     Allowed slowdown for --compare (default 0.25)
+
+Example:
+    make bench
+    make bench BENCH_ARGS="--quick --csv bench_output.txt"
+"""
+
+import argparse
+import bisect
+import csv
+import os
+import random
+import resource
+import subprocess
+import sys
+import threading
+import time
+from typing import Dict, List, Optional, Tuple
+
+# --- Configuration ---
+SCHEDULER_EXECUTABLE = './scheduler'
+WORKLOAD_DIR = 'bench_workloads'
+DEFAULT_SIZES = [1000, 10000, 100000, 1000000]
+DEFAULT_CPUS = [1, 4, 16, 64]
+DEFAULT_ALGORITHMS = ['FCFS', 'SJF', 'RR', 'SRTF', 'MLFQ', 'PRIO', 'PPRIO']
+QUICK_SIZES = [1000, 10000]
+QUICK_CPUS = [1, 4]
+DEFAULT_QUANTUM = 2
+DEFAULT_TOLERANCE = 0.25
+MIN_COMPARE_SECONDS = 0.05  # Runs faster than this are too noisy to compare
+RSS_POLL_SECONDS = 0.001  # VmHWM sampling interval for runs that stay below our own peak
+
+CSV_FIELDS = ['Algorithm', 'Processes', 'CPUs', 'Completed', 'TotalTime', 'Events',
+              'WallSeconds', 'NsPerTick', 'NsPerEvent', 'PeakRssKB']
+
+
+# --- Workload Generation ---
+
+def parse_priority_mix(spec: str) -> List[Tuple[int, float]]:
+    """Parse "prio:weight,..." into (priority, weight) pairs."""
+    mix = []
+    for item in spec.split(','):
+        prio, _, weight = item.partition(':')
+        mix.append((int(prio), float(weight) if weight else 1.0))
+    return mix
+
+
+def generate_workload(count: int, seed: int, arrival_rate: float, burst_dist: str,
+                      burst_mean: float, pareto_alpha: float,
+                      priority_mix: List[Tuple[int, float]]) -> List[Tuple[int, int, int, int]]:
+    """
+    Generate `count` processes sorted by arrival time.
+
+    Inter-arrival gaps are exponential with `arrival_rate` jobs per time unit
+    (a Poisson process). Bursts are exponential with mean `burst_mean`, or
+    Pareto with shape `pareto_alpha` scaled to the same mean, and never
+    shorter than one time unit.
+    """
+    rng = random.Random(seed)
+    priorities = [p for p, _ in priority_mix]
+    weights = [w for _, w in priority_mix]
+    pareto_scale = burst_mean * (pareto_alpha - 1) / pareto_alpha if pareto_alpha > 1 else burst_mean
+
+    jobs = []
+    clock = 0.0
+    for pid in range(1, count + 1):
+        clock += rng.expovariate(arrival_rate)
+        if burst_dist == 'pareto':
+            burst = pareto_scale * rng.paretovariate(pareto_alpha)
+        else:
+            burst = rng.expovariate(1.0 / burst_mean)
+        jobs.append((pid, int(clock), max(1, int(round(burst))), rng.choices(priorities, weights)[0]))
+    return jobs
+
+
+def write_workload(jobs: List[Tuple[int, int, int, int]], out) -> None:
+    """Write jobs in the scheduler's "PID arrival burst priority" format."""
+    out.write('# PID Arrival Burst Priority\n')
+    out.writelines(f'{pid} {arrival} {burst} {prio}\n' for pid, arrival, burst, prio in jobs)
+
+
+def workload_file(count: int, args: argparse.Namespace) -> Tuple[str, List[int]]:
+    """
+    Return the path of a cached workload for `count` and its sorted arrivals.
+
+    The file name encodes every generator parameter, so changing one makes
+    a new file instead of reusing a stale one.
+    """
+    os.makedirs(WORKLOAD_DIR, exist_ok=True)
+    name = (f'n{count}_s{args.seed}_r{args.arrival_rate}_{args.burst_dist}{args.burst_mean}'
+            f'_a{args.pareto_alpha}_p{args.priorities.replace(":", "-").replace(",", "_")}.txt')
+    path = os.path.join(WORKLOAD_DIR, name)
+    jobs = generate_workload(count, args.seed, args.arrival_rate, args.burst_dist,
+                             args.burst_mean, args.pareto_alpha, parse_priority_mix(args.priorities))
+    if not os.path.exists(path):
+        with open(path, 'w') as f:
+            write_workload(jobs, f)
+    return path, [arrival for _, arrival, _, _ in jobs]
+
+
+# --- Running ---
+
+def peak_rss_kb(pid: int) -> Optional[int]:
+    """Return VmHWM of a running process in KB, or None once it has exited."""
+    try:
+        with open(f'/proc/{pid}/status') as f:
+            for line in f:
+                if line.startswith('VmHWM:'):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return None
+
+
+def run_once(executable: str, path: str, algorithm: str, cpus: int,
+             quantum: int) -> Tuple[Optional[str], float, Optional[int]]:
+    """
+    Run the scheduler once; return (stdout, wall seconds, peak RSS in KB).
+
+    The peak is None if the run exited before it could be sampled.
+    """
+    cmd = [executable, '-f', path, '-a', algorithm, '-c', str(cpus), '-q', str(quantum), '--output', 'csv']
+    parent_rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    chunks: List[str] = []
+    reader = threading.Thread(target=lambda: chunks.append(proc.stdout.read()))
+    reader.start()
+    # Linux carries maxrss across fork and exec, so the child's rusage never
+    # reports less than this script's own peak; sample its VmHWM while it runs
+    sampled = None
+    while True:
+        hwm = peak_rss_kb(proc.pid)
+        if hwm is not None:
+            sampled = max(sampled or 0, hwm)
+        pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+        if pid:
+            break
+        time.sleep(RSS_POLL_SECONDS)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    wall = time.perf_counter() - start
+    reader.join()
+    proc.stdout.close()
+    if proc.returncode != 0:
+        return None, wall, None
+    # Above our own peak the rusage figure is the child's and exact
+    rss = usage.ru_maxrss if usage.ru_maxrss > parent_rss else sampled  # KB on Linux
+    return ''.join(chunks), wall, rss
+
+
+def parse_run(output: str) -> Tuple[int, int]:
+    """Return (completed processes, total simulated time) from CSV output."""
+    completed = 0
+    total_time = 0
+    section = None
+    for line in output.splitlines():
+        line = line.strip()
+        if line.endswith('(CSV):'):
+            section = line
+            continue
+        if not line or line.startswith(('PID,', 'CPU_ID,', 'Avg', '---')):
+            continue
+        fields = line.split(',')
+        if section == 'Process Stats (CSV):' and len(fields) == 9 and fields[4] != 'N/A':
+            completed += 1
+        elif section == 'CPU Stats (CSV):' and len(fields) == 4 and total_time == 0:
+            total_time = int(fields[1]) + int(fields[2])  # Busy + idle spans the whole run
+    return completed, total_time
+
+
+def count_events(arrivals: List[int], completed: int, total_time: int) -> int:
+    """Arrivals inside the simulated horizon plus completions."""
+    return bisect.bisect_left(arrivals, total_time) + completed
+
+
+def run_suite(args: argparse.Namespace) -> List[Dict[str, str]]:
+    """Run every (size, algorithm, CPU count) combination and print a table."""
+    rows = []
+    header = f"{'Algorithm':<9} {'N':>8} {'CPUs':>4} {'Done':>8} {'Ticks':>7} {'Wall s':>8} " \
+             f"{'ns/tick':>11} {'ns/event':>10} {'RSS KB':>9}"
+    print(header)
+    print('-' * len(header))
+    for size in args.sizes:
+        path, arrivals = workload_file(size, args)
+        for algorithm in args.algorithms:
+            for cpus in args.cpus:
+                output, wall, rss = run_once(args.executable, path, algorithm, cpus, args.quantum)
+                if output is None:
+                    print(f'{algorithm:<9} {size:>8} {cpus:>4} FAILED')
+                    continue
+                completed, total_time = parse_run(output)
+                events = count_events(arrivals, completed, total_time)
+                ns_tick = wall * 1e9 / total_time if total_time else 0.0
+                ns_event = wall * 1e9 / events if events else 0.0
+                print(f'{algorithm:<9} {size:>8} {cpus:>4} {completed:>8} {total_time:>7} {wall:>8.3f} '
+                      f"{ns_tick:>11.0f} {ns_event:>10.0f} {'-' if rss is None else rss:>9}")
+                rows.append({'Algorithm': algorithm, 'Processes': str(size), 'CPUs': str(cpus),
+                             'Completed': str(completed), 'TotalTime': str(total_time),
+                             'Events': str(events), 'WallSeconds': f'{wall:.6f}',
+                             'NsPerTick': f'{ns_tick:.0f}', 'NsPerEvent': f'{ns_event:.0f}',
+                             'PeakRssKB': '' if rss is None else str(rss)})
+    return rows
+
+
+def compare_to_baseline(rows: List[Dict[str, str]], baseline_path: str, tolerance: float) -> int:
+    """Print runs slower than baseline by more than `tolerance`; return how many."""
+    with open(baseline_path) as f:
+        baseline = {(r['Algorithm'], r['Processes'], r['CPUs']): r for r in csv.DictReader(f)}
+    regressions = 0
+    for row in rows:
+        old = baseline.get((row['Algorithm'], row['Processes'], row['CPUs']))
+        if old is None:
+            continue
+        old_wall, new_wall = float(old['WallSeconds']), float(row['WallSeconds'])
+        if max(old_wall, new_wall) < MIN_COMPARE_SECONDS:
+            continue
+        if new_wall > old_wall * (1 + tolerance):
+            regressions += 1
+            print(f"REGRESSION {row['Algorithm']} N={row['Processes']} CPUs={row['CPUs']}: "
+                  f"{old_wall:.3f}s -> {new_wall:.3f}s")
+    return regressions
+
+
+# --- Main ---
+
+def int_list(arg: str) -> List[int]:
+    return [int(float(v)) for v in arg.split(',')]
+
+
+def add_generator_options(parser: argparse.ArgumentParser) -> None:
+    parser.add_argument('--seed', type=int, default=453, help='Random seed (default 453)')
+    parser.add_argument('--arrival-rate', type=float, default=1.0, help='Mean arrivals per time unit')
+    parser.add_argument('--burst-dist', choices=['exp', 'pareto'], default='exp', help='Burst distribution')
+    parser.add_argument('--burst-mean', type=float, default=4.0, help='Mean burst length')
+    parser.add_argument('--pareto-alpha', type=float, default=1.5, help='Pareto shape (heavy tail below 2)')
+    parser.add_argument('--priorities', default='0:5,1:3,2:2', help='Priority mix as prio:weight,...')
+
+
+def main() -> None:
+    if len(sys.argv) > 1 and sys.argv[1] == 'gen':
+        parser = argparse.ArgumentParser(description='Print a synthetic workload.')
+        parser.add_argument('gen')
+        parser.add_argument('-n', '--count', type=int, required=True, help='Number of processes')
+        add_generator_options(parser)
+        args = parser.parse_args()
+        jobs = generate_workload(args.count, args.seed, args.arrival_rate, args.burst_dist,
+                                 args.burst_mean, args.pareto_alpha, parse_priority_mix(args.priorities))
+        write_workload(jobs, sys.stdout)
+        return
+
+    parser = argparse.ArgumentParser(description='Scaling benchmark for the CPU scheduler.')
+    parser.add_argument('--executable', default=SCHEDULER_EXECUTABLE, help='Path to the scheduler executable')
+    parser.add_argument('--sizes', type=int_list, default=None, help='Process counts, e.g. 1000,1e6')
+    parser.add_argument('--cpus', type=int_list, default=None, help='CPU counts')
+    parser.add_argument('--algorithms', type=lambda s: s.upper().split(','), default=DEFAULT_ALGORITHMS,
+                        help='Algorithms to run')
+    parser.add_argument('--quantum', type=int, default=DEFAULT_QUANTUM, help='RR time quantum')
+    parser.add_argument('--quick', action='store_true', help='Small grid for a fast smoke run')
+    parser.add_argument('--csv', help='Write results as CSV to this file')
+    parser.add_argument('--compare', help='Baseline CSV from an earlier --csv run')
+    parser.add_argument('--tolerance', type=float, default=DEFAULT_TOLERANCE, help='Allowed slowdown fraction')
+    add_generator_options(parser)
+    args = parser.parse_args()
+
+    if args.sizes is None:
+        args.sizes = QUICK_SIZES if args.quick else DEFAULT_SIZES
+    if args.cpus is None:
+        args.cpus = QUICK_CPUS if args.quick else DEFAULT_CPUS
+    if not os.path.isfile(args.executable):
+        print(f'Error: scheduler executable not found at {args.executable} (run make first)')
+        sys.exit(1)
+
+    rows = run_suite(args)
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+            writer.writeheader()
+            writer.writerows(rows)
+    if args.compare:
+        regressions = compare_to_baseline(rows, args.compare, args.tolerance)
+        print(f'\n{regressions} regression(s) against {args.compare}')
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
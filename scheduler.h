@@ -0,0 +1,137 @@
+/**
+ * libscheduler: the CPU scheduler simulator as an embeddable library
+ *
+ * `make lib` builds libscheduler.a and libscheduler.so from the same source as
+ * the command-line tool. A run keeps all of its state in locals, so calls are
+ * independent and may run on several threads at once. Nothing is printed;
+ * errors come back as return codes. Running out of memory inside the simulation
+ * itself (queues, timeline) still aborts the process, as in the CLI.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SCHED_API __attribute__((visibility("default")))
+#else
+#define SCHED_API
+#endif
+
+// Algorithm identifiers (the values the CLI uses internally)
+#define SCHED_ALGO_FCFS  0  // First-Come, First-Served
+#define SCHED_ALGO_RR    1  // Round Robin
+#define SCHED_ALGO_SRTF  2  // Shortest Remaining Time First
+#define SCHED_ALGO_SJF   3  // Shortest Job First
+#define SCHED_ALGO_MLFQ  4  // Multilevel Feedback Queue
+#define SCHED_ALGO_PRIO  5  // Priority, non-preemptive
+#define SCHED_ALGO_PPRIO 6  // Priority, preemptive
+
+/**
+ * One job of a workload, the fields of a "<PID> <arrival> <burst> [priority]" line
+ */
+typedef struct {
+    int pid;              // Process ID
+    int arrival_time;     // Time when the job becomes available
+    int burst_time;       // Total CPU time required
+    int priority;         // Higher value = higher priority
+} SchedJob;
+
+/**
+ * Parameters of one run; sched_default_config() gives the CLI defaults
+ */
+typedef struct {
+    int algorithm;        // SCHED_ALGO_* identifier
+    int cpu_count;        // Number of CPUs, at least 1
+    int time_quantum;     // RR quantum (top MLFQ level), at least 1 when used
+    int aging;            // PRIO/PPRIO waiting time per priority step, 0 = off
+} SchedConfig;
+
+/**
+ * Final statistics of one job, in input order
+ */
+typedef struct {
+    int pid;
+    int arrival_time;
+    int burst_time;
+    int priority;
+    int start_time;       // -1 if never started
+    int finish_time;      // -1 if not finished
+    int turnaround_time;  // finish - arrival (completed only, else 0)
+    int waiting_time;     // Time spent ready but not running (completed only, else 0)
+    int response_time;    // start - arrival (-1 if never started)
+    int completed;        // Nonzero if the job finished
+} SchedProcessResult;
+
+/**
+ * Final statistics of one CPU
+ */
+typedef struct {
+    int id;
+    int busy_time;
+    int idle_time;
+    double utilization;   // Busy share of total time, in percent
+} SchedCpuResult;
+
+/**
+ * Everything the CLI's CSV blocks report; release with sched_free_results()
+ */
+typedef struct {
+    SchedProcessResult *processes; // process_count entries
+    int process_count;
+    SchedCpuResult *cpus; // cpu_count entries
+    int cpu_count;
+    int total_time;       // Final clock value
+    int completed_count;  // Jobs that finished
+    double avg_turnaround; // Means over completed jobs (0 if none completed)
+    double avg_waiting;
+    double avg_response;
+    double utilization;   // Busy share of all CPU time, in percent
+    int stopped_early;    // Nonzero if the run hit its time limit with jobs unfinished
+} SchedResults;
+
+/**
+ * Fill `config` with the CLI defaults (FCFS, 1 CPU, quantum 2, no aging)
+ */
+SCHED_API void sched_default_config(SchedConfig *config);
+
+/**
+ * Simulate `jobs` under `config` and store the statistics in `results`
+ *
+ * Returns 0 on success, -1 for invalid arguments and -2 if the inputs or
+ * results could not be allocated; on error `results` is left empty. A run that
+ * never finishes stops at a limit derived from the workload, with
+ * `stopped_early` set. The jobs are not modified.
+ */
+SCHED_API int sched_run(const SchedJob *jobs, int job_count, const SchedConfig *config, SchedResults *results);
+
+/**
+ * Release the arrays of a results struct filled by sched_run()
+ */
+SCHED_API void sched_free_results(SchedResults *results);
+
+/**
+ * Load a text or binary workload file into a new job array
+ *
+ * Returns 0 on success (a file without valid records gives 0 jobs) and -1 if
+ * the file cannot be read. Release the array with sched_free_jobs().
+ */
+SCHED_API int sched_load_jobs(const char *filename, SchedJob **jobs, int *job_count);
+
+/**
+ * Release a job array from sched_load_jobs()
+ */
+SCHED_API void sched_free_jobs(SchedJob *jobs);
+
+/**
+ * Look up an algorithm by its CLI name ("FCFS", "RR", ...); -1 if unknown
+ */
+SCHED_API int sched_parse_algorithm(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHEDULER_H
@@ -6,6 +6,8 @@
  * - Round Robin (RR)
  * - Shortest Remaining Time First (SRTF)
  * - Shortest Job First (SJF)
+ * - Multilevel Feedback Queue (MLFQ)
+ * - Priority, non-preemptive and preemptive (PRIO, PPRIO), with optional aging
  * 
  * Features:
  * - Multiple CPU support
@@ -19,15 +21,29 @@
 #include <stdbool.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+
+#include "scheduler.h"
 
 /************************* CONSTANTS & DEFINITIONS *************************/
 
-// Scheduling algorithm identifiers
+// Scheduling algorithm identifiers (the SCHED_ALGO_* values of scheduler.h)
 typedef enum {
     FCFS = 0,  // First-Come, First-Served
     RR   = 1,  // Round Robin
     SRTF = 2,  // Shortest Remaining Time First (preemptive)
-    SJF  = 3   // Shortest Job First (non-preemptive)
+    SJF  = 3,  // Shortest Job First (non-preemptive)
+    MLFQ = 4,  // Multilevel Feedback Queue (RR levels with demotion)
+    PRIO = 5,  // Highest priority first (non-preemptive)
+    PPRIO = 6  // Highest priority first (preemptive)
 } Algorithm;
 
 // Process states
@@ -38,11 +54,58 @@ typedef enum {
     READY      = 3   // In the ready queue (specifically for RR)
 } ProcessState;
 
+// Timeline storage layouts
+typedef enum {
+    TIMELINE_GRID = 0,  // Contiguous time x CPU array of PIDs
+    TIMELINE_RLE  = 1,  // Per-CPU run-length encoded segments
+    TIMELINE_NONE = 2   // Nothing recorded; only the covered horizon is tracked
+} TimelineStorage;
+
+// Output sections, combined as a bit mask
+#define OUTPUT_TIMELINE 0x1  // Visual execution timeline
+#define OUTPUT_SUMMARY  0x2  // Human-readable process, CPU and average tables
+#define OUTPUT_CSV      0x4  // CSV blocks for automated testing
+#define OUTPUT_ALL      (OUTPUT_TIMELINE | OUTPUT_SUMMARY | OUTPUT_CSV)
+
+// Simulation clock modes
+typedef enum {
+    SIM_TICK  = 0,  // Advance one time unit per loop iteration
+    SIM_EVENT = 1   // Jump straight to the next arrival/completion/expiry
+} SimMode;
+
 // Configuration constants
 #define DEFAULT_TIME_QUANTUM 2
-#define MAX_PROCESSES 500
 #define INITIAL_TIMELINE_CAPACITY 1000
 #define MAX_LINE_LENGTH 256
+#define LOAD_BLOCK_SIZE (1 << 20)
+#define STREAM_BLOCK_SIZE (1 << 16)
+#define STREAM_INITIAL_SLOTS 1024
+#define MLFQ_LEVELS 3          // RR levels; level k gets quantum << k
+#define MLFQ_BOOST_PERIOD 50   // Every job returns to level 0 this often
+#define AFFINITY_LOOKAHEAD 16  // Queued jobs --affinity looks at beyond one per idle CPU
+#define RADIX_SORT_MIN 256  // Below this the arrival index just uses qsort
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_MIN_BLOCK (64 * 1024)
+#define BINARY_MAGIC_LENGTH 8
+#define WORKLOAD_MAGIC "SCHDWL1\n" // First bytes of a binary workload (the newline ends it for line readers)
+#define RESULTS_MAGIC  "SCHDRS1\n" // First bytes of a binary results dump
+#define CHECKPOINT_MAGIC "SCHDCK1\n" // First bytes of a checkpoint file
+#define DEFAULT_CHECKPOINT_INTERVAL 100
+
+// Scan kernels get an AVX2 copy next to the baseline (SSE2/NEON) one and the
+// loader picks whichever the CPU supports (ThreadSanitizer cannot run ifunc resolvers)
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && !defined(__SANITIZE_THREAD__)
+#define SIMD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
+// Latency histograms (--percentiles): exact below 2^HISTOGRAM_SUB_BITS, then 64 buckets per power of two
+#define HISTOGRAM_SUB_BITS 7
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS + (31 - HISTOGRAM_SUB_BITS) * (HISTOGRAM_SUB_BUCKETS / 2))
+#define LATENCY_MAX_CLASSES 32 // Priority values broken down separately
 
 // Display settings
 #define TIMELINE_WIDTH 80
@@ -65,8 +128,31 @@ const char *PROCESS_COLORS[] = {
 };
 #define NUM_PROCESS_COLORS (sizeof(PROCESS_COLORS) / sizeof(PROCESS_COLORS[0]))
 
+const char *LATENCY_METRIC_NAMES[] = {"Turnaround", "Waiting", "Response"};
+
 /************************* TYPE DEFINITIONS *************************/
 
+/**
+ * Header of one arena block; the usable bytes follow it
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *prev; // Block filled before this one (NULL for the first)
+    size_t size;          // Usable bytes in the block
+    size_t used;          // Bytes handed out so far
+    size_t last;          // Offset of the latest allocation, for in-place growth
+} ArenaBlock;
+
+/**
+ * Bump allocator holding all per-run simulation state
+ *
+ * Nothing is freed on its own; arena_reset() drops everything at once and
+ * keeps a single block big enough for the run that just finished.
+ */
+typedef struct {
+    ArenaBlock *head;     // Block allocations currently come from
+    size_t total;         // Bytes handed out since the last reset, over all blocks
+} Arena;
+
 /**
  * Process data structure containing all information about a process
  */
@@ -80,8 +166,13 @@ typedef struct {
     int start_time;       // When process first started (-1 if not started)
     int finish_time;      // When process completed (-1 if not finished)
     int waiting_time;     // Total time spent waiting
+    int ready_since;      // When the process last entered the ready queue (-1 if not queued)
     int quantum_used;     // Time units used in current quantum (for RR)
+    int level;            // MLFQ level (0 = highest priority)
+    int aged;             // Priority steps gained while waiting (PRIO/PPRIO --aging)
+    int aging_due;        // When the next aging step is due (-1 if not waiting)
     int response_time;    // Time between arrival and first execution
+    int last_cpu;         // CPU the process was last dispatched on (-1 if never)
 } Process;
 
 /**
@@ -92,1042 +183,6120 @@ typedef struct {
     Process *current_process; // Process currently running (NULL if idle)
     int idx;
     int idle_time;        // Total time CPU was idle
-    int busy_time;        // Total time CPU was busy
+    int busy_time;        // Total time CPU was busy, including overhead
+    int last_pid;         // PID last dispatched here (-1 before the first)
+    int overhead_left;    // Switch/migration time still to pay before the process progresses
+    int overhead_time;    // Busy time spent on switches and migrations
+    int same_cpu_dispatches; // Dispatches of a process that last ran on this CPU
+    int migrated_dispatches; // Dispatches of a process that last ran on another CPU
 } CPU;
 
+// Simulation loop stages timed by --stats
+typedef enum {
+    STAGE_ARRIVALS,
+    STAGE_QUANTUM,
+    STAGE_DISPATCH,
+    STAGE_PREEMPTION,
+    STAGE_TIMELINE,
+    STAGE_EXECUTE,
+    STAGE_COUNT
+} SimStage;
+
+// Ready queue orderings, one per queue_key_* setter
+typedef enum {
+    ORDER_REMAINING,      // queue_key_remaining (SJF/SRTF)
+    ORDER_ARRIVAL,        // queue_key_arrival (FCFS)
+    ORDER_PRIORITY,       // queue_key_priority (PRIO/PPRIO)
+    ORDER_COUNT
+} QueueOrder;
+
 /**
- * Simple circular queue for RR scheduling
+ * Hot-path counters collected with --stats (all zero-cost pointers when off)
  */
 typedef struct {
-    int process_indices[MAX_PROCESSES]; // Array of process indices
-    int front;            // Index of front element
-    int rear;             // Index of rear element
-    int size;             // Current queue size
-} ReadyQueue;
-
+    unsigned long enqueues;          // Entries added to the ready queue
+    unsigned long dequeues;          // Entries taken from the ready queue
+    unsigned long scan_steps[ORDER_COUNT]; // Heap comparisons per ordering
+    unsigned long preemptions;       // SRTF, MLFQ and PPRIO preemptions
+    unsigned long quantum_expiries;  // RR and MLFQ quantum expiries
+    unsigned long aging_steps;       // Priority steps granted by --aging
+    unsigned long idle_scans;        // CPUs examined by assign_processes_to_idle_cpus()
+    unsigned long loop_steps;        // Simulation loop iterations
+    int cpu_count;
+    unsigned long *dispatches;       // Per CPU: processes put on the CPU
+    unsigned long *context_switches; // Per CPU: dispatches of a different process than the last one run
+    int *last_pid;                   // Per CPU: PID last run (-1 before the first)
+    long long stage_ns[STAGE_COUNT]; // Time spent in each loop stage
+} SimStats;
 
+/**
+ * Log-linear histogram of non-negative times, fixed size whatever the job count
+ */
+typedef struct {
+    unsigned long counts[HISTOGRAM_BUCKETS]; // Values per bucket, see histogram_index()
+    unsigned long total;  // Values recorded
+    int max;              // Largest value recorded (exact)
+} Histogram;
 
-/************************* FUNCTION PROTOTYPES *************************/
+/**
+ * Latency histograms of one group of completed processes
+ */
+typedef struct {
+    int priority;         // Priority value of the class (unused for the overall group)
+    Histogram turnaround;
+    Histogram waiting;
+    Histogram response;
+} LatencyClass;
 
-// File operations
-void load_processes(const char *filename, Process **processes_ptr, int *count);
+/**
+ * Streaming latency percentiles collected with --percentiles
+ */
+typedef struct {
+    LatencyClass all;     // Every completed process
+    LatencyClass *classes; // One per priority value, sorted, at most LATENCY_MAX_CLASSES
+    int class_count;
+    unsigned long dropped; // Completions whose priority found no free class
+} LatencyMetrics;
 
-// Scheduling functions
-void simulate(Process *processes, int process_count, int cpu_count, Algorithm algorithm, int time_quantum);
-void handle_arrivals(Process *processes, int process_count, int current_time, Algorithm algorithm, 
-                    int *arrived_indices, int *arrival_count);
-void handle_rr_quantum_expiry(Process *processes, CPU *cpus, int cpu_count, int time_quantum, 
-                             ReadyQueue *ready_queue, int current_time);
-void handle_srtf_preemption(Process *processes, int process_count, CPU *cpus, int cpu_count, int current_time);
-void assign_processes_to_idle_cpus(Process *processes, int process_count, CPU *cpus, int cpu_count, 
-                                 Algorithm algorithm, ReadyQueue *ready_queue, int current_time);
-void execute_processes(Process *processes, int process_count, CPU *cpus, int cpu_count, 
-                      int current_time, int *completed_count);
-void update_waiting_times(Process *processes, int process_count, int current_time);
+// Where arrivals go when every CPU has its own run queue (--runqueues)
+typedef enum {
+    PLACE_GLOBAL,         // One shared ready queue (default)
+    PLACE_ROUND_ROBIN,    // Per-CPU queues, arrivals dealt out in turn
+    PLACE_LEAST_LOADED    // Per-CPU queues, arrivals to the CPU with the least work
+} QueuePlacement;
 
-// Output and visualization
-void print_results(Process *processes, int process_count, CPU *cpus, int cpu_count, int **timeline, int total_time);
-void print_timeline(int **timeline, int total_time, Process *processes, int process_count, int cpu_count);
-void print_process_stats(Process *processes, int process_count);
-void print_cpu_stats(CPU *cpus, int cpu_count);
-void print_average_stats(Process *processes, int process_count);
-void print_csv_output(Process *processes, int process_count, CPU *cpus, int cpu_count);
+/**
+ * One ready queue slot: the process index plus a copy of its sort keys
+ *
+ * Keeping the keys next to the index lets heap comparisons stay inside the
+ * queue array instead of chasing two Process records per comparison.
+ */
+typedef struct {
+    long long primary;    // First sort key (remaining time or arrival time)
+    unsigned long seq;    // Insertion stamp that breaks key ties
+    int secondary;        // Second sort key (~priority)
+    int tertiary;         // Third sort key (PID)
+    int process_idx;      // Index into the process array
+} QueueEntry;
 
-// Queue operations
-void init_queue(ReadyQueue *q);
-void enqueue(ReadyQueue *q, int process_idx);
-int dequeue(ReadyQueue *q);
+/**
+ * Ready queue of process indices
+ *
+ * A plain circular FIFO (RR, MLFQ levels) unless queue_set_order() gives it
+ * an ordering before the run starts, after which it is a binary min-heap on
+ * that ordering. A queue holds one ordering for its whole life.
+ */
+typedef struct {
+    QueueEntry *entries;  // Circular buffer (FIFO) or heap array (ordered)
+    int capacity;         // Allocated slots; doubles when full
+    int front;            // Index of front element
+    int rear;             // Index of rear element
+    int size;             // Current queue size
+    bool ordered;         // Heap on `order` (false for a plain FIFO)
+    QueueOrder order;     // Heap ordering once ordered
+    void (*key)(const Process *p, QueueEntry *e); // Sort-key setter of `order`
+    Process *processes;   // Process array the indices refer to (heap)
+    unsigned long next_seq; // Next insertion stamp
+    SimStats *stats;      // Counters to update, or NULL
+    Arena *arena;         // Where the entries live
+    int *positions;       // Heap slot of each process index (-1 if not queued), or NULL without heap_update()
+} ReadyQueue;
 
-// Timeline management
-void init_timeline(int ***timeline_ptr, int capacity, int cpu_count);
-void expand_timeline(int ***timeline_ptr, int *capacity_ptr, int new_capacity, int cpu_count);
-void cleanup_timeline(int **timeline, int capacity);
+/**
+ * Per-CPU ready queues with placement and work-stealing accounting
+ */
+typedef struct {
+    ReadyQueue *queues;   // One queue per CPU
+    int count;            // Number of queues (= CPUs)
+    QueuePlacement placement; // Arrival placement policy
+    int next_cpu;         // Next CPU for round-robin placement
+    unsigned long *steals; // Per CPU: jobs taken from a peer's queue
+    long long *length_time; // Per CPU: queue length summed over time units
+    int *max_length;      // Per CPU: longest queue seen
+} RunQueues;
 
-// Helper functions
-const char* get_color_for_pid(int pid);
-const char* algorithm_name(Algorithm algorithm);
-void parse_arguments(int argc, char *argv[], Algorithm *algorithm, int *cpu_count, 
-                    int *time_quantum, char **input_file);
+/**
+ * MLFQ ready queues: one RR FIFO per level plus a bitmap of non-empty levels
+ *
+ * The lowest set bit of `nonempty` is the level to serve next, so picking a
+ * job never scans the levels.
+ */
+typedef struct {
+    ReadyQueue levels[MLFQ_LEVELS]; // Level 0 is served first
+    unsigned nonempty;    // Bit k is set while levels[k] holds a job
+} MlfqQueues;
 
+/**
+ * One run-length encoded stretch of a CPU's schedule
+ */
+typedef struct {
+    int cpu;              // CPU the segment belongs to
+    int pid;              // Process ID that ran (-1 for idle)
+    int start;            // First time unit of the segment
+    int end;              // One past the last time unit
+} TimelineSegment;
 
-// GLOBAL QUEUE
-ReadyQueue FCFSQ;
-/************************* QUEUE OPERATIONS *************************/
+/**
+ * Record of which process ran on each CPU at each time unit
+ */
+typedef struct {
+    TimelineStorage storage; // Which of the representations below is in use
+    int capacity;         // Time units reserved so far
+    int cpu_count;        // Number of CPUs per time unit
+    int *cells;           // GRID: capacity * cpu_count PIDs, row-major by time
+    TimelineSegment **segments; // RLE: per-CPU segment arrays in time order
+    int *segment_counts;  // RLE: segments used per CPU
+    int *segment_capacities; // RLE: segments allocated per CPU
+    Arena *arena;         // Where the cells and segments live
+} Timeline;
 
 /**
- * Initialize a ready queue
+ * Part of the timeline to print (--timeline-window, --timeline-summary)
  */
-void init_queue(ReadyQueue *q) {
-    q->front = 0;
-    q->rear = -1;
-    q->size = 0;
-}
+typedef struct {
+    int start;            // First time unit shown
+    int end;              // One past the last time unit shown, -1 = the end of the run
+    int bucket;           // Time units per column; above 1 a column shows the PID that ran longest
+} TimelineWindow;
 
 /**
- * Add a process index to the ready queue
+ * Time one PID held a CPU within a summary column
  */
+typedef struct {
+    int pid;              // Process ID (-1 for idle)
+    int length;           // Time units of this run
+    int first;            // Order of the run within the column, for ties
+} TimelineShare;
 
-//  static void print_queue(const ReadyQueue *q) {
-//     printf("Q front=%d rear=%d size=%d: ", q->front, q->rear, q->size);
-//     for (int k = 0; k < q->size; k++) {
-//         int idx = (q->front + k) % MAX_PROCESSES;
-//         printf("%d ", q->process_indices[idx]);
-//     }
-//     printf("\n");
-// }
+/**
+ * Sort key used to build the arrival-order index
+ */
+typedef struct {
+    int arrival_time;     // Arrival time of the process
+    int idx;              // Index into the loaded process array
+} ArrivalEntry;
 
+/**
+ * Header of a binary workload file, followed by record_count records
+ *
+ * All binary formats are fixed width and little-endian. A record is at least
+ * a WorkloadRecord; longer records leave room for fields this reader ignores.
+ */
+typedef struct {
+    char magic[BINARY_MAGIC_LENGTH]; // WORKLOAD_MAGIC
+    uint32_t record_size; // Bytes per record, a multiple of 4
+    uint32_t flags;       // Reserved, written as 0
+    uint64_t record_count; // Records after the header
+} WorkloadHeader;
 
-void enqueue(ReadyQueue *q, int process_idx) {
-    if (q->size >= MAX_PROCESSES) {
-        fprintf(stderr, "Error: Ready queue overflow!\n");
-        return;
-    }
-    q->rear = (q->rear + 1) % MAX_PROCESSES;
-    q->process_indices[q->rear] = process_idx;
-    q->size++;
-}
+/**
+ * One process of a binary workload, the fields of a text line
+ */
+typedef struct {
+    int32_t pid;
+    int32_t arrival_time;
+    int32_t burst_time;
+    int32_t priority;
+} WorkloadRecord;
 
-void enqueue_priority(ReadyQueue *q, int process_idx , Process *processes){
-    if (q->size >= MAX_PROCESSES) {
-        fprintf(stderr, "Error: Ready queue overflow!\n");
-        return;
-    }
+/**
+ * Header of a binary results dump (--dump)
+ *
+ * Followed by process_count process records, cpu_count CPU records and
+ * segment_count timeline segments, in that order.
+ */
+typedef struct {
+    char magic[BINARY_MAGIC_LENGTH]; // RESULTS_MAGIC
+    int32_t algorithm;    // Algorithm value of the run
+    int32_t cpu_count;    // Number of CPUs
+    int32_t time_quantum; // Quantum of the run
+    int32_t total_time;   // Final clock value
+    int32_t has_timeline; // Whether the run recorded a timeline at all
+    int32_t locality;     // Whether the run reports same-CPU and migrated dispatches
+    uint64_t process_count; // Process records, in input order
+    uint64_t segment_count; // Busy timeline segments, by CPU then time
+} ResultsHeader;
 
-    if (q->rear == -1){
-        enqueue(q , process_idx);
-        return;
-    }
+/**
+ * Final state of one process in a results dump
+ */
+typedef struct {
+    int32_t pid;
+    int32_t arrival_time;
+    int32_t burst_time;
+    int32_t priority;
+    int32_t start_time;   // -1 if never started
+    int32_t finish_time;  // -1 if not finished
+    int32_t waiting_time;
+    int32_t response_time; // -1 if never started
+} ResultsProcessRecord;
 
-    int cur = q->front; 
-    int new_time = processes[process_idx].remaining_time;
-    int new_priority = processes[process_idx].priority; 
-    int new_pid = processes[process_idx].pid;
+/**
+ * Final counters of one CPU in a results dump
+ */
+typedef struct {
+    int32_t id;
+    int32_t busy_time;
+    int32_t idle_time;
+    int32_t overhead_time; // Switch and migration time within busy_time
+    int32_t same_cpu_dispatches;
+    int32_t migrated_dispatches;
+} ResultsCpuRecord;
 
-    // scan queue from front to rear
-    while (cur != (q->rear + 1) % MAX_PROCESSES){
-        int cur_time = processes[q->process_indices[cur]].remaining_time;
-        int cur_priority = processes[q->process_indices[cur]].priority;
-        int cur_pid = processes[q->process_indices[cur]].pid;
+/**
+ * One stretch of a CPU running one process in a results dump
+ */
+typedef struct {
+    int32_t cpu;
+    int32_t pid;
+    int32_t start;        // First time unit
+    int32_t end;          // One past the last time unit
+} ResultsSegmentRecord;
 
-        if (new_time < cur_time || 
-           (new_time == cur_time && new_priority > cur_priority)
-            || (new_time == cur_time && new_priority == cur_priority && new_pid < cur_pid)){
-            break;
-        }
-        cur = (cur + 1) % MAX_PROCESSES;
-    }
+/**
+ * Growable byte buffer
+ */
+typedef struct {
+    char *data;           // Bytes written so far
+    size_t size;          // Bytes in use
+    size_t capacity;      // Bytes allocated
+} ByteBuffer;
 
-    if (cur == (q->rear + 1) % MAX_PROCESSES){  
-        enqueue(q , process_idx);
-        return;
-    }
+/**
+ * Snapshots of one run's state, taken every `interval` time units (--checkpoint)
+ */
+typedef struct {
+    int interval;         // Time units between checkpoints
+    int next_time;        // Take the next checkpoint at the first loop step at or after this
+    int count;            // Frames collected
+    ByteBuffer frames;    // CheckpointFrames, in time order
+} CheckpointLog;
 
-    q->rear = (q->rear + 1) % MAX_PROCESSES;    
+/**
+ * Header of a checkpoint file
+ *
+ * Followed by the final state of every process (Process records, which also
+ * carry the workload), the busy timeline runs as ResultsSegmentRecords and
+ * then checkpoint_count frames. Frames hold raw in-memory records, so a file
+ * is only read back by a build with the same record sizes and byte order.
+ */
+typedef struct {
+    char magic[BINARY_MAGIC_LENGTH]; // CHECKPOINT_MAGIC
+    uint32_t process_size; // sizeof(Process) of the writer
+    uint32_t entry_size;  // sizeof(QueueEntry) of the writer
+    int32_t algorithm;    // Configuration a resumed run must repeat
+    int32_t cpu_count;
+    int32_t time_quantum;
+    int32_t aging;
+    int32_t placement;
+    int32_t process_count; // Processes in the workload of the run
+    int32_t total_time;   // Final clock value of the run
+    int32_t checkpoint_count; // Frames at the end of the file
+    int32_t has_timeline; // Whether the timeline runs below were recorded
+    int32_t switch_cost;  // Overhead model a resumed run must repeat
+    int32_t migration_cost;
+    int32_t affinity;
+    uint64_t segment_count; // Timeline runs after the process records
+} CheckpointHeader;
 
-    int temp = q->process_indices[cur];
-    q->process_indices[cur] = process_idx;
+/**
+ * Start of one checkpoint, taken at the top of a loop step before arrivals
+ *
+ * Followed by live_count CheckpointProcesses, one CheckpointCpu per CPU,
+ * queue_count queues (a CheckpointQueue then its entries in service order)
+ * and, with per-CPU run queues, their counters. Processes that arrived before
+ * `time` and are not listed had completed by then, so their final state is
+ * their state at the checkpoint; the rest had not arrived yet.
+ */
+typedef struct {
+    uint64_t bytes;       // Size of the whole frame
+    int32_t time;         // Clock value
+    int32_t completed_count; // Processes finished before `time`
+    int32_t live_count;   // Arrived, unfinished processes listed in the frame
+    int32_t queue_count;  // Ready queues in the frame
+} CheckpointFrame;
 
-    int temp2;
-    int nextcur = (cur + 1) % MAX_PROCESSES;
+/**
+ * State of one arrived, unfinished process in a checkpoint
+ */
+typedef struct {
+    int32_t process_idx;  // Index in the workload of the checkpointed run
+    Process state;        // The process as it was
+} CheckpointProcess;
 
-    while (cur != q->rear){                      // FIX: clearer stop condition
-        temp2 = q->process_indices[nextcur];
-        q->process_indices[nextcur] = temp;
-        temp = temp2;
+/**
+ * State of one CPU in a checkpoint
+ */
+typedef struct {
+    int32_t process_idx;  // Process running on it, -1 if idle
+    int32_t last_idx;     // CPU.idx
+    int32_t idle_time;
+    int32_t busy_time;
+    int32_t last_pid;
+    int32_t overhead_left;
+    int32_t overhead_time;
+    int32_t same_cpu_dispatches;
+    int32_t migrated_dispatches;
+    int32_t reserved;     // Written as 0
+} CheckpointCpu;
 
-        cur = nextcur;                        
-        nextcur = (cur + 1) % MAX_PROCESSES;  
-    }
+/**
+ * Bookkeeping of one ready queue in a checkpoint; `size` entries follow
+ */
+typedef struct {
+    int32_t size;
+    int32_t ordered;      // Heap (1) or FIFO (0)
+    int32_t order;        // QueueOrder of a heap
+    int32_t reserved;     // Written as 0
+    uint64_t next_seq;    // Next insertion stamp
+} CheckpointQueue;
 
-    q->size++;
-}
+/**
+ * Counters of one per-CPU run queue in a checkpoint
+ */
+typedef struct {
+    uint64_t steals;
+    int64_t length_time;
+    int32_t max_length;
+    int32_t reserved;     // Written as 0
+} CheckpointRunQueue;
 
-void enqueue_priority2(ReadyQueue *q, int process_idx , Process *processes){
-    if (q->size >= MAX_PROCESSES) {
-        fprintf(stderr, "Error: Ready queue overflow!\n");
-        return;
-    }
 
-    if (q->rear == -1){
-        enqueue(q , process_idx);
-        return;
-    }
+/**
+ * Growable list of integers (command-line values, free slots)
+ */
+typedef struct {
+    int *values;          // List entries
+    int count;            // Entries in use
+    int capacity;         // Entries allocated
+} IntList;
 
-    int cur = q->front; 
-    int new_time = processes[process_idx].arrival_time;
-    int new_priority = processes[process_idx].priority; 
-    int new_pid = processes[process_idx].pid;
+/**
+ * Growable list of strings (workload file names)
+ */
+typedef struct {
+    char **values;        // List entries
+    int count;            // Entries in use
+    int capacity;         // Entries allocated
+} StringList;
 
-    // scan queue from front to rear
-    while (cur != (q->rear + 1) % MAX_PROCESSES){
-        int cur_time = processes[q->process_indices[cur]].arrival_time;
-        int cur_priority = processes[q->process_indices[cur]].priority;
-        int cur_pid = processes[q->process_indices[cur]].pid;
+/**
+ * Incremental reader for "<PID> <arrival> <burst> [priority]" records
+ *
+ * Input that starts with WORKLOAD_MAGIC is read as binary records instead.
+ */
+typedef struct {
+    int fd;               // Input descriptor (stdin for "-")
+    const char *name;     // Name used in error messages
+    char *buffer;         // Read buffer holding at least one partial line
+    size_t start;         // First unconsumed byte in buffer
+    size_t end;           // One past the last valid byte in buffer
+    size_t capacity;      // Allocated buffer size
+    bool eof;             // No more input will arrive
+    bool has_pending;     // pending holds a record that was peeked but not taken
+    int pending[4];       // PID, arrival, burst, priority of the next record
+    int last_arrival;     // Arrival time of the last record read
+    long line_number;     // Lines (or binary records) read so far
+    bool binary;          // Input is a binary workload
+    size_t record_size;   // Bytes per binary record
+} StreamSource;
+
+struct ParallelPool;
 
-        if ( (new_time == cur_time) && (
-           (new_priority > cur_priority)
-            || (new_priority == cur_priority && new_pid < cur_pid))){
-            break;
-        }
-        cur = (cur + 1) % MAX_PROCESSES;
-    }
+/**
+ * One thread's contiguous block of CPUs
+ */
+typedef struct {
+    struct ParallelPool *pool; // Pool the slice belongs to
+    int first_cpu;        // First CPU of the block
+    int last_cpu;         // One past the last CPU of the block
+} ParallelSlice;
 
-    if (cur == (q->rear + 1) % MAX_PROCESSES){  
-        enqueue(q , process_idx);
-        return;
-    }
+/**
+ * Threads sharing the per-CPU work of each step (-j)
+ */
+typedef struct ParallelPool {
+    struct SimulationContext *ctx; // Context being simulated
+    int threads;          // Threads including the caller
+    pthread_t *tids;      // Helper threads (slot 0 unused: the caller)
+    ParallelSlice *slices; // CPU block of each thread
+    pthread_barrier_t start; // Released when a step is ready (or on quit)
+    pthread_barrier_t done;  // Reached once every block has run
+    int elapsed;          // Length of the current step
+    bool quit;            // Tells the helpers to exit at the next start
+    bool *finished;       // Per CPU: its process completed in this step
+} ParallelPool;
+
+struct SimulationContext;
 
-    q->rear = (q->rear + 1) % MAX_PROCESSES;    
+/**
+ * Per-algorithm steps of the main loop, chosen once per run by select_policy()
+ *
+ * The loop calls these instead of testing the algorithm, the queue layout or
+ * --affinity each time unit. A NULL tick, preempt or quantum means the policy
+ * has nothing to do at that point.
+ */
+typedef struct {
+    void (*admit)(struct SimulationContext *ctx, int idx); // Queue a process arriving now
+    void (*tick)(struct SimulationContext *ctx);    // Quantum expiry, boosts or aging before dispatch
+    void (*assign)(struct SimulationContext *ctx);  // Fill idle CPUs
+    void (*preempt)(struct SimulationContext *ctx); // Preemption check after dispatch
+    int (*take)(struct SimulationContext *ctx, int c); // Next ready job for idle CPU c, -1 if none
+    void (*requeue)(struct SimulationContext *ctx, int c, int idx); // Queue a job whose quantum ran out on c
+    int (*quantum)(const struct SimulationContext *ctx, const Process *p); // Quantum of a running job
+    int boost_period;     // Time between MLFQ priority boosts, 0 = none
+} Policy;
 
-    int temp = q->process_indices[cur];
-    q->process_indices[cur] = process_idx;
+/**
+ * All state of one simulation run
+ *
+ * Owns the ready queue, CPUs, timeline and counters; nothing is global, so
+ * several contexts can be simulated in the same process. Their storage comes
+ * from the arena the caller passes in.
+ */
+typedef struct SimulationContext {
+    // Workload and configuration
+    Process *processes;   // Process array being simulated (owned by the caller)
+    int process_count;    // Number of processes
+    int cpu_count;        // Number of CPUs
+    Algorithm algorithm;  // Scheduling algorithm
+    int time_quantum;     // Quantum for RR (top MLFQ level)
+    SimMode mode;         // Tick or event-driven clock
+    Policy policy;        // Loop steps of the algorithm, filled in when the run starts
+
+    // Scheduler state
+    Arena *arena;         // Holds everything below (owned by the caller)
+    ReadyQueue ready_queue; // Processes waiting for a CPU
+    CPU *cpus;            // CPU array
+    Timeline timeline;    // Which process ran where and when
+    int *arrival_order;   // Process indices sorted by arrival time
+    int arrival_cursor;   // First entry of arrival_order not yet arrived
+    int *arrived_indices; // Processes that arrived in the current time unit
+    int arrival_count;    // Number of entries in arrived_indices
+    int arrived_capacity; // Entries allocated in arrived_indices
+
+    // Streaming input (stream is NULL when the whole workload was loaded)
+    StreamSource *stream; // Source of not-yet-arrived processes
+    int process_capacity; // Slots allocated in processes
+    IntList free_slots;   // Slots of completed processes, ready for reuse
+    unsigned stream_output; // OUTPUT_* sections printed while running
+    double stream_turnaround; // Running totals over completed processes
+    double stream_waiting;
+    double stream_response;
+
+    // Counters
+    int current_time;     // Simulation clock
+    int completed_count;  // Processes finished so far
+    int total_time;       // Final clock value once the run ends
+    bool trace;           // Print scheduling events to stderr (--trace)
+    int max_time;         // Horizon: the run stops here even with jobs left (--max-time)
+    bool stopped_early;   // The run reached max_time with processes unfinished
+    bool quiet;           // Leave the --max-time warning to the caller (library runs)
+    SimStats *stats;      // Hot-path counters (--stats), or NULL
+    LatencyMetrics *latency; // Percentile histograms updated at completion (--percentiles), or NULL
+    RunQueues *runqueues; // Per-CPU ready queues (--runqueues), or NULL for the global one
+    MlfqQueues *mlfq;     // Level queues when running MLFQ, or NULL
+    int aging_period;     // PRIO/PPRIO: waiting time per priority step (0 = no aging)
+    int switch_cost;      // Time a dispatch of a different process costs its CPU (--switch-cost)
+    int migration_cost;   // Extra time when the process last ran on another CPU (--migration-cost)
+    int affinity_wait;    // Time a job waits for its last CPU before any CPU may take it, -1 = off (--affinity)
+    int affinity_deadline; // Earliest time a job held for its CPU may move (INT_MAX if none)
+    QueueEntry *affinity_window; // Jobs taken off the queue for one --affinity dispatch round
+    ReadyQueue aging;     // Waiting processes in order of their next aging step
+    ParallelPool *parallel; // Threads sharing per-CPU work (-j), or NULL when serial
+    CheckpointLog *checkpoints; // Snapshots being collected (--checkpoint), or NULL
+} SimulationContext;
 
-    int temp2;
-    int nextcur = (cur + 1) % MAX_PROCESSES;
+/**
+ * Final statistics of one process
+ */
+typedef struct {
+    int pid;              // Process ID
+    int arrival_time;     // Arrival time
+    int burst_time;       // Total CPU time required
+    int priority;         // Priority
+    int start_time;       // First execution (-1 if never started)
+    int finish_time;      // Completion (-1 if not finished)
+    int turnaround_time;  // finish - arrival (completed only)
+    int waiting_time;     // turnaround - burst (completed only)
+    int response_time;    // start - arrival (-1 if never started)
+    bool completed;       // Whether the process finished
+} ProcessResult;
 
-    while (cur != q->rear){                      // FIX: clearer stop condition
-        temp2 = q->process_indices[nextcur];
-        q->process_indices[nextcur] = temp;
-        temp = temp2;
+/**
+ * Final statistics of one CPU
+ */
+typedef struct {
+    int id;               // CPU identifier
+    int busy_time;        // Time spent running processes
+    int idle_time;        // Time spent idle
+    int overhead_time;    // Part of busy_time spent on switches and migrations
+    int same_cpu_dispatches; // Dispatches of a process that last ran here
+    int migrated_dispatches; // Dispatches of a process that last ran elsewhere
+    double utilization;   // Busy share of total time, in percent
+} CpuResult;
 
-        cur = nextcur;                        
-        nextcur = (cur + 1) % MAX_PROCESSES;  
-    }
+/**
+ * Everything the printers report, computed once per run
+ */
+typedef struct {
+    ProcessResult *processes; // Per-process statistics, in input order
+    int process_count;    // Number of processes
+    CpuResult *cpus;      // Per-CPU statistics
+    int cpu_count;        // Number of CPUs
+    int total_time;       // Final clock value
+    int completed_count;  // Processes that finished
+    double avg_turnaround; // Mean turnaround of completed processes
+    double avg_waiting;   // Mean waiting of completed processes
+    double avg_response;  // Mean response of completed processes
+    double utilization;   // Busy share of all CPU time, in percent
+    long overhead_time;   // Busy time spent on switches and migrations, over all CPUs
+    bool locality;        // Report same-CPU and migrated dispatches per CPU
+    const SimStats *stats; // Counters to report (--stats), or NULL
+    const LatencyMetrics *latency; // Percentiles to report (--percentiles), or NULL
+    const RunQueues *runqueues; // Per-CPU queue statistics to report, or NULL
+} SimulationResults;
 
-    q->size++;
-    //print_queue(q);
-}
+/**
+ * Command line options
+ */
+typedef struct {
+    char *input_file;     // Workload file (the first -f)
+    StringList input_files; // Every -f argument, files or directories (not owned)
+    bool batch;           // Several -f files or a directory: one sweep table over all of them
+    IntList algorithms;   // Algorithms to run (-a), as Algorithm values
+    IntList cpu_counts;   // CPU counts to run (-c)
+    IntList quanta;       // RR quanta to run (-q)
+    SimMode mode;         // Clock mode (-m)
+    TimelineStorage storage; // Timeline layout (--timeline)
+    bool sweep;           // Print one CSV row per configuration (--sweep)
+    int workers;          // Sweep worker threads, 0 = one per online core (--workers)
+    unsigned output;      // OUTPUT_* sections to print (--output)
+    TimelineWindow window; // Part of the timeline to print (--timeline-window, --timeline-summary)
+    bool stream;          // Admit records incrementally (-f - or --stream)
+    bool stats;           // Collect and print hot-path counters (--stats)
+    bool percentiles;     // Collect and print latency percentiles (--percentiles)
+    QueuePlacement placement; // Global or per-CPU ready queues (--runqueues)
+    int threads;          // Threads for the per-CPU work of one run (-j)
+    int aging;            // PRIO/PPRIO waiting time per priority step, 0 = off (--aging)
+    int switch_cost;      // Time units a context switch costs (--switch-cost)
+    int migration_cost;   // Extra time units a cross-CPU migration costs (--migration-cost)
+    int affinity;         // Wait threshold of affinity-preferring dispatch, -1 = off (--affinity)
+    int max_time;         // Stop a run at this time, 0 = derived from the workload (--max-time)
+    bool trace;           // Print every scheduling event to stderr (--trace)
+    char *binary_out;     // Write the workload as a binary file and exit (--write-binary)
+    char *text_out;       // Write the workload as a text file and exit (--write-text)
+    char *dump_file;      // Binary results of the run (--dump)
+    char *replay_file;    // Print a results dump instead of simulating (--replay)
+    char *checkpoint_file; // Write checkpoints of the run here (--checkpoint)
+    int checkpoint_interval; // Time units between checkpoints (--checkpoint-every)
+    char *resume_file;    // Start from the latest usable checkpoint in this file (--resume)
+} Options;
 
-//this is the last one i swear
-void enqueue_priority3(ReadyQueue *q, int process_idx , Process *processes){
-    if (q->size >= MAX_PROCESSES) {
-        fprintf(stderr, "Error: Ready queue overflow!\n");
-        return;
-    }
+/**
+ * One loaded workload of a sweep or batch
+ */
+typedef struct {
+    char *file;           // File it was loaded from (owned in batch mode)
+    Process *processes;   // Pristine process array, NULL if the file had none
+    int process_count;    // Number of processes
+} Workload;
 
-    if (q->rear == -1){
-        enqueue(q , process_idx);
-        return;
-    }
+/**
+ * Files loaded by the batch loader threads
+ */
+typedef struct {
+    Workload *workloads;  // One entry per file, in command-line order
+    int workload_count;   // Number of files
+    int next_file;        // Next file to load
+    pthread_mutex_t lock; // Guards next_file
+} BatchLoader;
 
-    int cur = q->front; 
-    int new_run_time = processes[process_idx].burst_time - processes[process_idx].remaining_time;
-    int new_arr_time = processes[process_idx].arrival_time;
-    int new_priority = processes[process_idx].priority; 
-    int new_pid = processes[process_idx].pid;
+/**
+ * Configuration and averages of one sweep run
+ */
+typedef struct {
+    int workload;         // Index of the workload it simulates
+    Algorithm algorithm;  // Scheduling algorithm
+    int cpu_count;        // Number of CPUs
+    int time_quantum;     // RR quantum (unused by the other algorithms)
+    int completed;        // Processes that finished
+    int total_time;       // Final clock value
+    double avg_turnaround; // Mean turnaround of completed processes
+    double avg_waiting;   // Mean waiting of completed processes
+    double avg_response;  // Mean response of completed processes
+    double utilization;   // Busy share of all CPU time, in percent
+} SweepRun;
 
-    // scan queue from front to rear
-    while (cur != (q->rear + 1) % MAX_PROCESSES){
-        int cur_run_time = processes[q->process_indices[cur]].burst_time -processes[q->process_indices[cur]].remaining_time;
-        int cur_arr_time = processes[q->process_indices[cur]].arrival_time;
-        int cur_priority = processes[q->process_indices[cur]].priority;
-        int cur_pid = processes[q->process_indices[cur]].pid;
+/**
+ * Work shared by the sweep worker threads
+ */
+typedef struct {
+    const Workload *workloads; // Pristine process arrays every run copies
+    int max_process_count; // Largest workload, the size of each worker's copy
+    SimMode mode;         // Clock mode for every run
+    QueuePlacement placement; // Ready queue layout for every run
+    int aging;            // PRIO/PPRIO aging period for every run
+    int switch_cost;      // Overhead model for every run
+    int migration_cost;
+    int affinity;         // Affinity wait threshold for every run, -1 = off
+    int max_time;         // --max-time for every run, 0 = derived from the workload
+    SweepRun *runs;       // One entry per configuration
+    int run_count;        // Number of configurations
+    int next_run;         // Next configuration to hand out
+    pthread_mutex_t lock; // Guards next_run
+} SweepPool;
 
-        if ( (new_run_time < cur_run_time) ||
-        (new_run_time == cur_run_time && new_arr_time < cur_arr_time) ||
-        (new_run_time == cur_run_time && new_arr_time == cur_arr_time && new_priority > cur_priority) ||
-        (new_run_time == cur_run_time && new_arr_time == cur_arr_time && new_priority == cur_priority && new_pid < cur_pid)){
-            break;
-        }
-        cur = (cur + 1) % MAX_PROCESSES;
-    }
+/************************* FUNCTION PROTOTYPES *************************/
 
-    if (cur == (q->rear + 1) % MAX_PROCESSES){  
-        enqueue(q , process_idx);
-        return;
-    }
+// Parallel execution
+void init_parallel(SimulationContext *ctx, int threads);
+void cleanup_parallel(SimulationContext *ctx);
+void execute_slice(ParallelSlice *slice);
+void *parallel_worker(void *arg);
+void execute_parallel(SimulationContext *ctx, int elapsed);
+
+// Per-CPU run queues
+void init_runqueues(SimulationContext *ctx, QueuePlacement placement);
+void cleanup_runqueues(SimulationContext *ctx);
+ReadyQueue *cpu_queue(SimulationContext *ctx, int c);
+ReadyQueue *arrival_queue(SimulationContext *ctx);
+int runqueue_take(SimulationContext *ctx, int c);
+void sample_runqueues(SimulationContext *ctx, int elapsed);
+void handle_srtf_preemption_per_cpu(SimulationContext *ctx);
+void print_runqueue_stats(const RunQueues *rq, int total_time);
+void print_csv_runqueues(const RunQueues *rq, int total_time);
+const char* placement_name(QueuePlacement placement);
+
+// Multilevel feedback queue
+void init_mlfq(SimulationContext *ctx);
+int lowest_set_bit(unsigned mask);
+int mlfq_quantum(int time_quantum, int level);
+void mlfq_enqueue(MlfqQueues *m, int process_idx, int level);
+int mlfq_dequeue(MlfqQueues *m);
+void mlfq_boost(SimulationContext *ctx);
+void handle_mlfq_preemption(SimulationContext *ctx);
+
+// Priority scheduling
+void init_aging(SimulationContext *ctx, int period);
+void enqueue_by_priority(SimulationContext *ctx, int process_idx);
+void handle_aging(SimulationContext *ctx);
+void handle_priority_preemption(SimulationContext *ctx);
+bool algorithm_needs_global_queue(Algorithm algorithm);
+
+// Instrumentation
+void init_stats(SimStats *stats, int cpu_count);
+void attach_stats(SimulationContext *ctx, SimStats *stats);
+void free_stats(SimStats *stats);
+
+// Latency percentiles
+int histogram_index(int value);
+int histogram_bucket_top(int index);
+void histogram_add(Histogram *histogram, int value);
+int histogram_percentile(const Histogram *histogram, int per_ten_thousand);
+void init_latency(LatencyMetrics *latency);
+LatencyClass *latency_class(LatencyMetrics *latency, int priority);
+void record_latency(LatencyMetrics *latency, const Process *p);
+void free_latency(LatencyMetrics *latency);
+void print_latency(const LatencyMetrics *latency);
+void print_csv_latency(const LatencyMetrics *latency);
+long long stats_now_ns(void);
+void stats_lap(SimStats *stats, SimStage stage, long long *mark);
+void stats_dispatch(SimStats *stats, int c, const Process *p);
+void print_sim_stats(const SimStats *stats);
+void print_csv_stats(const SimStats *stats);
+
+// Streaming input
+void open_stream(StreamSource *stream, const char *filename);
+void close_stream(StreamSource *stream);
+bool stream_refill(StreamSource *stream);
+bool stream_fill(StreamSource *stream, size_t bytes);
+bool stream_read_line(StreamSource *stream, const char **line, const char **line_end);
+bool stream_peek(StreamSource *stream, int fields[4]);
+int alloc_process_slot(SimulationContext *ctx);
+void retire_stream_process(SimulationContext *ctx, int slot);
+void init_stream_simulation(SimulationContext *ctx, StreamSource *stream, int cpu_count, Algorithm algorithm,
+                            int time_quantum, SimMode mode, unsigned output, Arena *arena);
+void run_stream(const Options *opts);
 
-    q->rear = (q->rear + 1) % MAX_PROCESSES;    
+// File operations
+void load_processes(const char *filename, Process **processes_ptr, int *count);
+bool read_process_file(const char *filename, Process **processes_ptr, int *count);
+void init_process(Process *p, int pid, int arrival, int burst, int priority);
+void append_process(Process **processes_ptr, int *count, int *capacity,
+                    int pid, int arrival, int burst, int priority);
+bool parse_int_token(const char **p, const char *end, int *value);
+int parse_process_line(const char *line, const char *end, int fields[4]);
+void parse_process_buffer(const char *data, size_t size, Process **processes_ptr, int *count, int *capacity);
+void load_process_data(const char *data, size_t size, const char *filename,
+                       Process **processes_ptr, int *count, int *capacity);
+int *build_arrival_order(Process *processes, int process_count, Arena *arena);
+int compare_arrival_entries(const void *a, const void *b);
+static int count_descents(const int *keys, int n); // static: a target_clones ifunc ignores -fvisibility=hidden
+void radix_sort_arrivals(ArrivalEntry *entries, int n);
+
+// Binary traces
+uint32_t le32(uint32_t value);
+uint64_t le64(uint64_t value);
+bool is_binary_workload(const void *data, size_t size);
+void decode_binary_workload(const void *data, size_t size, const char *filename,
+                            Process **processes_ptr, int *count, int *capacity);
+void decode_workload_record(const void *record, int fields[4]);
+FILE *open_output_file(const char *filename);
+void close_output_file(FILE *f, const char *filename);
+void write_binary_workload(const char *filename, const Process *processes, int process_count);
+void write_text_workload(const char *filename, const Process *processes, int process_count);
+uint64_t write_timeline_runs(const Timeline *timeline, int total_time, FILE *f);
+void dump_results(const char *filename, const SimulationContext *ctx);
+void replay_results(const char *filename, unsigned output, const TimelineWindow *window);
+
+// Library API (scheduler.h)
+bool copy_results(const SimulationResults *from, SchedResults *to);
+
+// Checkpoints
+void buffer_append(ByteBuffer *buffer, const void *data, size_t bytes);
+int context_queue_count(const SimulationContext *ctx);
+ReadyQueue *context_queue(SimulationContext *ctx, int k);
+void init_checkpoints(SimulationContext *ctx, CheckpointLog *log, int interval);
+void record_checkpoint(SimulationContext *ctx);
+void write_checkpoints(const char *filename, const SimulationContext *ctx);
+void free_checkpoints(CheckpointLog *log);
+bool read_checkpoint_bytes(const char **cursor, const char *end, void *out, size_t bytes);
+int first_changed_arrival(const Process *old_processes, const int *old_order, int old_count,
+                          const Process *processes, const int *order, int count);
+int resume_simulation(SimulationContext *ctx, const char *filename);
 
-    int temp = q->process_indices[cur];
-    q->process_indices[cur] = process_idx;
+// Scheduling functions
+void simulate(Process *processes, int process_count, const Options *opts);
+void init_simulation(SimulationContext *ctx, Process *processes, int process_count, int cpu_count,
+                     Algorithm algorithm, int time_quantum, SimMode mode, TimelineStorage storage,
+                     Arena *arena);
+void run_simulation(SimulationContext *ctx);
+void select_policy(SimulationContext *ctx);
+void admit_fcfs(SimulationContext *ctx, int idx);
+void admit_rr(SimulationContext *ctx, int idx);
+void admit_shortest(SimulationContext *ctx, int idx);
+void admit_priority(SimulationContext *ctx, int idx);
+void admit_mlfq(SimulationContext *ctx, int idx);
+void mlfq_tick(SimulationContext *ctx);
+void order_queues(SimulationContext *ctx, QueueOrder order);
+int take_global(SimulationContext *ctx, int c);
+int take_mlfq(SimulationContext *ctx, int c);
+void requeue_global(SimulationContext *ctx, int c, int idx);
+void requeue_own(SimulationContext *ctx, int c, int idx);
+void requeue_demoted(SimulationContext *ctx, int c, int idx);
+int quantum_fixed(const SimulationContext *ctx, const Process *p);
+int quantum_mlfq(const SimulationContext *ctx, const Process *p);
+bool simulation_pending(SimulationContext *ctx);
+void cleanup_simulation(SimulationContext *ctx);
+void handle_arrivals(SimulationContext *ctx);
+void handle_rr_quantum_expiry(SimulationContext *ctx);
+void handle_srtf_preemption(SimulationContext *ctx);
+void assign_processes_to_idle_cpus(SimulationContext *ctx);
+void dispatch_process(SimulationContext *ctx, int c, int idx);
+void execute_processes(SimulationContext *ctx, int elapsed);
+bool execute_cpu(SimulationContext *ctx, int c, int elapsed);
+void finish_on_cpu(SimulationContext *ctx, int c);
+void dispatch_waited(Process *p, int current_time);
+void charge_dispatch(SimulationContext *ctx, int c, Process *p);
+void init_overhead(SimulationContext *ctx, int switch_cost, int migration_cost);
+void init_affinity(SimulationContext *ctx, int wait);
+void assign_with_affinity(SimulationContext *ctx);
+void init_horizon(SimulationContext *ctx, int max_time);
+void trace_event(int time, int c, const char *event, const Process *p);
+int next_event_delta(SimulationContext *ctx);
 
-    int temp2;
-    int nextcur = (cur + 1) % MAX_PROCESSES;
+// Output and visualization
+void compute_results(const Process *processes, int process_count, const CPU *cpus, int cpu_count,
+                     int total_time, SimulationResults *results);
+void free_results(SimulationResults *results);
+void print_results(Process *processes, int process_count, CPU *cpus, int cpu_count, const Timeline *timeline,
+                   int total_time, unsigned output, const TimelineWindow *window, const SimStats *stats,
+                   const LatencyMetrics *latency, const RunQueues *runqueues, bool locality);
+void print_timeline(const Timeline *timeline, int total_time, Process *processes, int process_count, int cpu_count,
+                    const TimelineWindow *window);
+void buffer_append_int(ByteBuffer *buffer, int value, int width);
+void buffer_append_cell(ByteBuffer *buffer, int pid, int width);
+int dominant_pid(TimelineShare *shares, int count);
+int compare_shares(const void *a, const void *b);
+void print_process_stats(const SimulationResults *results);
+void print_cpu_stats(const SimulationResults *results);
+double overhead_share(const CpuResult *cpu);
+void print_average_stats(const SimulationResults *results);
+void print_csv_output(const SimulationResults *results);
+void print_csv_process_header(void);
+void print_csv_process_row(const ProcessResult *p);
+void print_csv_tail(const SimulationResults *results);
+bool parse_output_list(const char *arg, unsigned *output);
+bool parse_time_window(const char *arg, TimelineWindow *window);
+
+// Arena allocation
+void init_arena(Arena *arena);
+void arena_reserve(Arena *arena, size_t bytes);
+void *arena_alloc(Arena *arena, size_t bytes);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+void *arena_grow(Arena *arena, void *ptr, size_t old_bytes, size_t new_bytes);
+void arena_reset(Arena *arena);
+void free_arena(Arena *arena);
+size_t estimate_arena_size(const Process *processes, int process_count, int cpu_count, TimelineStorage storage);
 
-    while (cur != q->rear){                      // FIX: clearer stop condition
-        temp2 = q->process_indices[nextcur];
-        q->process_indices[nextcur] = temp;
-        temp = temp2;
+// Queue operations
+void init_queue(ReadyQueue *q, int capacity, Arena *arena);
+void grow_queue(ReadyQueue *q);
+void free_queue(ReadyQueue *q);
+void enqueue(ReadyQueue *q, int process_idx);
+int dequeue(ReadyQueue *q);
+void queue_set_order(ReadyQueue *q, QueueOrder order, Process *processes);
+void queue_key_remaining(const Process *p, QueueEntry *e);
+void queue_key_arrival(const Process *p, QueueEntry *e);
+void queue_key_priority(const Process *p, QueueEntry *e);
+bool heap_slot_before(const ReadyQueue *q, int i, int j);
+void heap_swap(ReadyQueue *q, int i, int j);
+void heap_push(ReadyQueue *q, int process_idx);
+int heap_pop(ReadyQueue *q);
+void heap_sift_down(ReadyQueue *q, int i);
+void heap_update(ReadyQueue *q, int process_idx);
+bool queue_pop_entry(ReadyQueue *q, QueueEntry *out);
+void queue_restore_entry(ReadyQueue *q, const QueueEntry *e);
 
-        cur = nextcur;                        
-        nextcur = (cur + 1) % MAX_PROCESSES;  
-    }
+// Timeline management
+void init_timeline(Timeline *timeline, int capacity, int cpu_count, TimelineStorage storage, Arena *arena);
+void expand_timeline(Timeline *timeline, int new_capacity);
+void grow_timeline_segments(Timeline *timeline, int cpu);
+void timeline_reserve(Timeline *timeline, int end);
+void timeline_record(Timeline *timeline, int cpu, int pid, int start, int end);
+int timeline_pid_at(const Timeline *timeline, int cpu, int t, int *cursor);
+int timeline_seek(const Timeline *timeline, int cpu, int t);
+int timeline_run_end(const Timeline *timeline, int cpu, int t, int limit, int *cursor, int *pid);
+void cleanup_timeline(Timeline *timeline);
 
-    q->size++;
-    //print_queue(q);
-}
+// Helper functions
+const char* get_color_for_pid(int pid);
+const char* algorithm_name(Algorithm algorithm);
+void parse_arguments(int argc, char *argv[], Options *opts);
+bool parse_algorithm_name(const char *name, Algorithm *algorithm);
+bool parse_algorithm_list(const char *arg, IntList *list);
+bool parse_int_list(const char *arg, IntList *list, int fallback);
+void int_list_push(IntList *list, int value);
+void free_int_list(IntList *list);
+const char* algorithm_code(Algorithm algorithm);
+bool algorithm_uses_quantum(Algorithm algorithm);
+
+// Parameter sweep
+void *sweep_worker(void *arg);
+void run_sweep(const Options *opts, const Workload *workloads, int workload_count);
+void print_sweep_csv(const SweepRun *runs, int run_count, const Workload *workloads, bool batch);
+void print_csv_text(const char *text);
+
+// Batch mode
+void string_list_push(StringList *list, char *value);
+void free_string_list(StringList *list, bool owned);
+void expand_input_path(const char *path, StringList *files);
+int compare_strings(const void *a, const void *b);
+void *batch_load_worker(void *arg);
+Workload *load_batch(const Options *opts, int *workload_count);
+void free_workloads(Workload *workloads, int workload_count, bool owned);
+
+/************************* ARENA ALLOCATION *************************/
 
 /**
- * Remove and return the next process index from the ready queue
- * Returns -1 if queue is empty
+ * Start an empty arena; the first allocation or reservation makes a block
  */
-int dequeue(ReadyQueue *q) {
-    if (q->size <= 0) return -1; // Queue empty
-    int process_idx = q->process_indices[q->front];
-    q->front = (q->front + 1) % MAX_PROCESSES;
-    q->size--;
-    return process_idx;
+void init_arena(Arena *arena) {
+    arena->head = NULL;
+    arena->total = 0;
 }
 
-/************************* TIMELINE MANAGEMENT *************************/
-
 /**
- * Initialize the simulation timeline data structure
+ * Make sure the next `bytes` of allocations fit in the current block
+ *
+ * A new block is at least twice the size of the current one, and an empty
+ * current block is replaced rather than left behind in the chain.
  */
-void init_timeline(int ***timeline_ptr, int capacity, int cpu_count) {
-    *timeline_ptr = (int **)malloc(capacity * sizeof(int *));
-    if (!(*timeline_ptr)) {
-        perror("Failed to allocate timeline");
-        exit(EXIT_FAILURE);
+void arena_reserve(Arena *arena, size_t bytes) {
+    ArenaBlock *head = arena->head;
+    if (head && head->size - head->used >= bytes) return;
+
+    size_t size = bytes > ARENA_MIN_BLOCK ? bytes : ARENA_MIN_BLOCK;
+    if (head && size < head->size * 2) size = head->size * 2;
+    if (head && head->used == 0) {
+        arena->head = head->prev;
+        free(head);
     }
-    
-    for (int t = 0; t < capacity; t++) {
-        (*timeline_ptr)[t] = (int *)malloc(cpu_count * sizeof(int));
-        if (!(*timeline_ptr)[t]) {
-            perror("Failed to allocate timeline row");
-            // Clean up already allocated rows
-            for (int k = 0; k < t; k++) free((*timeline_ptr)[k]);
-            free(*timeline_ptr);
-            exit(EXIT_FAILURE);
-        }
-        for (int c = 0; c < cpu_count; c++) {
-            (*timeline_ptr)[t][c] = -1; // -1 indicates idle
-        }
+
+    ArenaBlock *block = (ArenaBlock *)malloc(ARENA_ROUND(sizeof(ArenaBlock)) + size);
+    if (!block) {
+        perror("Failed to allocate simulation arena");
+        exit(EXIT_FAILURE);
     }
+    block->prev = arena->head;
+    block->size = size;
+    block->used = 0;
+    block->last = 0;
+    arena->head = block;
 }
 
 /**
- * Expand timeline capacity when needed
+ * Hand out `bytes` of uninitialized storage, aligned for any field type
  */
-void expand_timeline(int ***timeline_ptr, int *capacity_ptr, int new_capacity, int cpu_count) {
-    int **temp = (int **)realloc(*timeline_ptr, new_capacity * sizeof(int *));
-    if (!temp) {
-        perror("Failed to expand timeline");
-        exit(EXIT_FAILURE);
-    }
-    *timeline_ptr = temp;
-
-    for (int t = *capacity_ptr; t < new_capacity; t++) {
-        (*timeline_ptr)[t] = (int *)malloc(cpu_count * sizeof(int));
-        if (!(*timeline_ptr)[t]) {
-            perror("Failed to allocate new timeline row during expansion");
-            exit(EXIT_FAILURE);
-        }
-        for (int c = 0; c < cpu_count; c++) {
-            (*timeline_ptr)[t][c] = -1;
-        }
-    }
-    *capacity_ptr = new_capacity;
+void *arena_alloc(Arena *arena, size_t bytes) {
+    bytes = ARENA_ROUND(bytes);
+    arena_reserve(arena, bytes);
+
+    ArenaBlock *head = arena->head;
+    void *ptr = (char *)head + ARENA_ROUND(sizeof(ArenaBlock)) + head->used;
+    head->last = head->used;
+    head->used += bytes;
+    arena->total += bytes;
+    return ptr;
 }
 
 /**
- * Clean up the timeline data structure
+ * arena_alloc() for `count` zeroed elements of `size` bytes
  */
-void cleanup_timeline(int **timeline, int capacity) {
-    if (timeline) {
-        for (int t = 0; t < capacity; t++) {
-            free(timeline[t]);
-        }
-        free(timeline);
-    }
+void *arena_calloc(Arena *arena, size_t count, size_t size) {
+    void *ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
 }
 
-/************************* HELPER FUNCTIONS *************************/
+/**
+ * Resize an arena allocation, keeping its first `old_bytes`
+ *
+ * The latest allocation grows in place when the block has room; anything
+ * else is copied and the old space stays dead until the next reset.
+ */
+void *arena_grow(Arena *arena, void *ptr, size_t old_bytes, size_t new_bytes) {
+    ArenaBlock *head = arena->head;
+    size_t aligned = ARENA_ROUND(new_bytes);
+    char *last = head ? (char *)head + ARENA_ROUND(sizeof(ArenaBlock)) + head->last : NULL;
+    if (ptr && ptr == last && head->last + aligned <= head->size) {
+        arena->total += head->last + aligned - head->used;
+        head->used = head->last + aligned;
+        return ptr;
+    }
+
+    void *moved = arena_alloc(arena, new_bytes);
+    if (ptr) memcpy(moved, ptr, old_bytes);
+    return moved;
+}
+
+/**
+ * Drop every allocation, leaving one block that fits the run just finished
+ */
+void arena_reset(Arena *arena) {
+    ArenaBlock *head = arena->head;
+    if (head && head->prev) {
+        size_t needed = arena->total;
+        free_arena(arena);
+        arena_reserve(arena, needed);
+    } else if (head) {
+        head->used = 0;
+        head->last = 0;
+    }
+    arena->total = 0;
+}
+
+/**
+ * Release every block of an arena
+ */
+void free_arena(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    arena->head = NULL;
+    arena->total = 0;
+}
+
+/**
+ * Bytes one simulation of this workload is expected to take from its arena
+ *
+ * The timeline horizon is guessed as total burst / CPUs + last arrival. A grid
+ * is reserved twice over because doubling leaves the old copies behind; pages
+ * the run never reaches are never touched.
+ */
+size_t estimate_arena_size(const Process *processes, int process_count, int cpu_count, TimelineStorage storage) {
+    long long total_burst = 0;
+    long long max_arrival = 0;
+    for (int i = 0; i < process_count; i++) {
+        total_burst += processes[i].burst_time;
+        if (processes[i].arrival_time > max_arrival) max_arrival = processes[i].arrival_time;
+    }
+    long long horizon = total_burst / (cpu_count > 0 ? cpu_count : 1) + max_arrival;
+    if (horizon < INITIAL_TIMELINE_CAPACITY) horizon = INITIAL_TIMELINE_CAPACITY;
+
+    size_t n = (size_t)(process_count > 0 ? process_count : 1);
+    size_t bytes = cpu_count * sizeof(CPU)
+                 + n * (sizeof(QueueEntry) + 2 * sizeof(int)) // ready queue, arrival index, arrivals
+                 + cpu_count * (sizeof(ReadyQueue) + 16 * sizeof(QueueEntry) + 64) // per-CPU queues
+                 + 3 * cpu_count * sizeof(void *)
+                 + 16 * ARENA_ALIGN;
+    if (storage == TIMELINE_GRID) {
+        bytes += 2 * (size_t)horizon * cpu_count * sizeof(int);
+    } else if (storage == TIMELINE_RLE) {
+        bytes += 2 * (n + 16 * (size_t)cpu_count) * sizeof(TimelineSegment);
+    }
+    return bytes;
+}
+
+/************************* QUEUE OPERATIONS *************************/
+
+/**
+ * Initialize a ready queue with room for `capacity` entries taken from `arena`
+ */
+void init_queue(ReadyQueue *q, int capacity, Arena *arena) {
+    if (capacity < 1) capacity = 1;
+    q->arena = arena;
+    q->entries = (QueueEntry *)arena_alloc(arena, capacity * sizeof(QueueEntry));
+    q->capacity = capacity;
+    q->front = 0;
+    q->rear = -1;
+    q->size = 0;
+    q->ordered = false;
+    q->order = ORDER_REMAINING;
+    q->key = NULL;
+    q->processes = NULL;
+    q->next_seq = 0;
+    q->stats = NULL;
+    q->positions = NULL;
+}
+
+/**
+ * Double the queue capacity, unwrapping a circular FIFO to start at slot 0
+ */
+void grow_queue(ReadyQueue *q) {
+    int new_capacity = q->capacity * 2;
+
+    // heap slots are already contiguous from 0 and can grow in place
+    if (q->ordered || q->front == 0) {
+        q->entries = (QueueEntry *)arena_grow(q->arena, q->entries, q->size * sizeof(QueueEntry),
+                                              new_capacity * sizeof(QueueEntry));
+        q->capacity = new_capacity;
+        q->front = 0;
+        q->rear = q->size - 1;
+        return;
+    }
+
+    // a wrapped FIFO is copied out starting at front
+    QueueEntry *entries = (QueueEntry *)arena_alloc(q->arena, new_capacity * sizeof(QueueEntry));
+    for (int k = 0; k < q->size; k++) {
+        entries[k] = q->entries[(q->front + k) % q->capacity];
+    }
+
+    q->entries = entries;
+    q->capacity = new_capacity;
+    q->front = 0;
+    q->rear = q->size - 1;
+}
+
+/**
+ * Detach the queue from its storage (the arena reclaims it on reset)
+ */
+void free_queue(ReadyQueue *q) {
+    q->entries = NULL;
+    q->capacity = 0;
+    q->size = 0;
+}
+
+/**
+ * Add a process index to the ready queue
+ */
+void enqueue(ReadyQueue *q, int process_idx) {
+    if (q->ordered) {
+        heap_push(q, process_idx);
+        return;
+    }
+    if (q->size >= q->capacity) grow_queue(q);
+    q->rear = (q->rear + 1) % q->capacity;
+    q->entries[q->rear].process_idx = process_idx;
+    q->size++;
+    if (q->stats) q->stats->enqueues++;
+}
+
+/**
+ * Turn an empty queue into a heap on `order` over `processes`
+ *
+ * Each ordering has its own key setter, picked here once so that pushes do
+ * not have to branch on the ordering. Smaller keys run first; a queued
+ * process does not run, so its keys cannot go stale while it waits, and heap
+ * comparisons never have to touch the Process records. Priorities are stored
+ * as ~priority so that a higher priority sorts first.
+ */
+void queue_set_order(ReadyQueue *q, QueueOrder order, Process *processes) {
+    q->ordered = true;
+    q->order = order;
+    q->processes = processes;
+    switch (order) {
+        case ORDER_REMAINING:
+            q->key = queue_key_remaining;
+            break;
+        case ORDER_ARRIVAL:
+            q->key = queue_key_arrival;
+            break;
+        default: // ORDER_PRIORITY
+            q->key = queue_key_priority;
+            break;
+    }
+}
+
+/**
+ * ORDER_REMAINING (SJF/SRTF): shorter remaining time, then higher priority,
+ * then lower PID
+ */
+void queue_key_remaining(const Process *p, QueueEntry *e) {
+    e->primary = p->remaining_time;
+    e->secondary = ~p->priority;
+    e->tertiary = p->pid;
+}
+
+/**
+ * ORDER_ARRIVAL (FCFS): earlier arrival, then higher priority, then lower PID
+ */
+void queue_key_arrival(const Process *p, QueueEntry *e) {
+    e->primary = p->arrival_time;
+    e->secondary = ~p->priority;
+    e->tertiary = p->pid;
+}
+
+/**
+ * ORDER_PRIORITY (PRIO/PPRIO): higher priority plus aging steps, then earlier
+ * arrival, then lower PID
+ *
+ * Aging is the one way keys change while queued, and it goes through
+ * heap_update().
+ */
+void queue_key_priority(const Process *p, QueueEntry *e) {
+    e->primary = -((long long)p->priority + p->aged);
+    e->secondary = p->arrival_time;
+    e->tertiary = p->pid;
+}
+
+/**
+ * Compare two heap slots; entries with equal keys leave in insertion order,
+ * the same way the old sorted-insert scan placed them
+ */
+bool heap_slot_before(const ReadyQueue *q, int i, int j) {
+    const QueueEntry *a = &q->entries[i];
+    const QueueEntry *b = &q->entries[j];
+    if (a->primary != b->primary) return a->primary < b->primary;
+    if (a->secondary != b->secondary) return a->secondary < b->secondary;
+    if (a->tertiary != b->tertiary) return a->tertiary < b->tertiary;
+    return a->seq < b->seq;
+}
+
+void heap_swap(ReadyQueue *q, int i, int j) {
+    QueueEntry e = q->entries[i];
+    q->entries[i] = q->entries[j];
+    q->entries[j] = e;
+    if (q->positions) {
+        q->positions[q->entries[i].process_idx] = i;
+        q->positions[q->entries[j].process_idx] = j;
+    }
+}
+
+/**
+ * Insert a process index into a heap-ordered ready queue in O(log n)
+ */
+void heap_push(ReadyQueue *q, int process_idx) {
+    if (q->size >= q->capacity) grow_queue(q);
+
+    int i = q->size++;
+    QueueEntry *e = &q->entries[i];
+    q->key(&q->processes[process_idx], e);
+    e->process_idx = process_idx;
+    e->seq = q->next_seq++;
+    if (q->positions) q->positions[process_idx] = i;
+
+    // sift up
+    int steps = 0;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        steps++;
+        if (!heap_slot_before(q, i, parent)) break;
+        heap_swap(q, i, parent);
+        i = parent;
+    }
+
+    if (q->stats) {
+        q->stats->enqueues++;
+        q->stats->scan_steps[q->order] += steps;
+    }
+}
+
+/**
+ * Remove the first process index of a heap-ordered ready queue in O(log n)
+ */
+int heap_pop(ReadyQueue *q) {
+    if (q->size <= 0) return -1; // Queue empty
+    int process_idx = q->entries[0].process_idx;
+
+    q->size--;
+    q->entries[0] = q->entries[q->size];
+    if (q->positions) {
+        q->positions[q->entries[0].process_idx] = 0;
+        q->positions[process_idx] = -1;
+    }
+
+    heap_sift_down(q, 0);
+    if (q->stats) q->stats->dequeues++;
+    return process_idx;
+}
+
+/**
+ * Move heap slot `i` down until neither child comes before it
+ */
+void heap_sift_down(ReadyQueue *q, int i) {
+    while (true) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int best = i;
+        if (left < q->size && heap_slot_before(q, left, best)) best = left;
+        if (right < q->size && heap_slot_before(q, right, best)) best = right;
+        if (best == i) break;
+        heap_swap(q, i, best);
+        i = best;
+    }
+}
+
+/**
+ * Update-key: recompute a queued process's keys and restore heap order
+ *
+ * O(log n) through `positions`, which the queue must have. The insertion
+ * stamp is kept, so ties still leave in arrival order.
+ */
+void heap_update(ReadyQueue *q, int process_idx) {
+    int i = q->positions[process_idx];
+    if (i < 0) return;
+    q->key(&q->processes[process_idx], &q->entries[i]);
+
+    while (i > 0 && heap_slot_before(q, i, (i - 1) / 2)) {
+        heap_swap(q, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    heap_sift_down(q, i);
+}
+
+/**
+ * Take the next entry off the queue with its keys, without counting a dequeue
+ */
+bool queue_pop_entry(ReadyQueue *q, QueueEntry *out) {
+    if (q->size <= 0) return false;
+    if (!q->ordered) {
+        *out = q->entries[q->front];
+        q->front = (q->front + 1) % q->capacity;
+        q->size--;
+        return true;
+    }
+    *out = q->entries[0];
+    q->size--;
+    q->entries[0] = q->entries[q->size];
+    if (q->positions) {
+        q->positions[q->entries[0].process_idx] = 0;
+        q->positions[out->process_idx] = -1;
+    }
+    heap_sift_down(q, 0);
+    return true;
+}
+
+/**
+ * Undo queue_pop_entry(); restore FIFO entries in reverse order of taking them
+ *
+ * A heap entry keeps its insertion stamp, so the queue serves exactly the
+ * same order as if it had never been taken.
+ */
+void queue_restore_entry(ReadyQueue *q, const QueueEntry *e) {
+    if (q->size >= q->capacity) grow_queue(q);
+    if (!q->ordered) {
+        q->front = (q->front - 1 + q->capacity) % q->capacity;
+        q->entries[q->front] = *e;
+        q->size++;
+        return;
+    }
+    int i = q->size++;
+    q->entries[i] = *e;
+    if (q->positions) q->positions[e->process_idx] = i;
+    while (i > 0 && heap_slot_before(q, i, (i - 1) / 2)) {
+        heap_swap(q, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * Remove and return the next process index from the ready queue
+ * Returns -1 if queue is empty
+ */
+int dequeue(ReadyQueue *q) {
+    if (q->ordered) return heap_pop(q);
+    if (q->size <= 0) return -1; // Queue empty
+    int process_idx = q->entries[q->front].process_idx;
+    q->front = (q->front + 1) % q->capacity;
+    q->size--;
+    if (q->stats) q->stats->dequeues++;
+    return process_idx;
+}
+
+/************************* TIMELINE MANAGEMENT *************************/
+
+/**
+ * Initialize the simulation timeline data structure
+ *
+ * `storage` picks a contiguous time x CPU grid or per-CPU run-length encoded
+ * segments; both are read back through timeline_pid_at().
+ */
+void init_timeline(Timeline *timeline, int capacity, int cpu_count, TimelineStorage storage, Arena *arena) {
+    timeline->storage = storage;
+    timeline->arena = arena;
+    timeline->capacity = 0;
+    timeline->cpu_count = cpu_count;
+    timeline->cells = NULL;
+    timeline->segments = NULL;
+    timeline->segment_counts = NULL;
+    timeline->segment_capacities = NULL;
+
+    if (storage == TIMELINE_RLE) {
+        timeline->segments = (TimelineSegment **)arena_calloc(arena, cpu_count, sizeof(TimelineSegment *));
+        timeline->segment_counts = (int *)arena_calloc(arena, cpu_count, sizeof(int));
+        timeline->segment_capacities = (int *)arena_calloc(arena, cpu_count, sizeof(int));
+    }
+    expand_timeline(timeline, capacity);
+}
+
+/**
+ * Expand timeline capacity when needed
+ *
+ * The grid is one row-major block, so growing it is a single arena_grow().
+ */
+void expand_timeline(Timeline *timeline, int new_capacity) {
+    if (timeline->storage == TIMELINE_GRID) {
+        size_t old_cells = (size_t)timeline->capacity * timeline->cpu_count;
+        size_t cells = (size_t)new_capacity * timeline->cpu_count;
+        timeline->cells = (int *)arena_grow(timeline->arena, timeline->cells, old_cells * sizeof(int),
+                                            cells * sizeof(int));
+        for (size_t k = old_cells; k < cells; k++) {
+            timeline->cells[k] = -1; // -1 indicates idle
+        }
+    }
+    timeline->capacity = new_capacity;
+}
+
+/**
+ * Record that `pid` (-1 for idle) ran on `cpu` for time units [start, end)
+ *
+ * In RLE storage this extends the CPU's last segment when the same PID
+ * continues without a gap, so only schedule changes cost memory.
+ */
+void timeline_record(Timeline *timeline, int cpu, int pid, int start, int end) {
+    while (end > timeline->capacity) {
+        expand_timeline(timeline, timeline->capacity * 2);
+    }
+
+    if (timeline->storage == TIMELINE_NONE) return;
+    if (timeline->storage == TIMELINE_GRID) {
+        for (int t = start; t < end; t++) {
+            timeline->cells[(size_t)t * timeline->cpu_count + cpu] = pid;
+        }
+        return;
+    }
+
+    int count = timeline->segment_counts[cpu];
+    TimelineSegment *last = count > 0 ? &timeline->segments[cpu][count - 1] : NULL;
+    if (last && last->pid == pid && last->end == start) {
+        last->end = end;
+        return;
+    }
+
+    if (count >= timeline->segment_capacities[cpu]) grow_timeline_segments(timeline, cpu);
+
+    TimelineSegment *seg = &timeline->segments[cpu][count];
+    seg->cpu = cpu;
+    seg->pid = pid;
+    seg->start = start;
+    seg->end = end;
+    timeline->segment_counts[cpu] = count + 1;
+}
+
+/**
+ * Double the RLE segment array of one CPU
+ */
+void grow_timeline_segments(Timeline *timeline, int cpu) {
+    int capacity = timeline->segment_capacities[cpu];
+    int new_capacity = capacity ? capacity * 2 : 16;
+    timeline->segments[cpu] = (TimelineSegment *)arena_grow(timeline->arena, timeline->segments[cpu],
+                                                            capacity * sizeof(TimelineSegment),
+                                                            new_capacity * sizeof(TimelineSegment));
+    timeline->segment_capacities[cpu] = new_capacity;
+}
+
+/**
+ * Make room so recording one more segment per CPU up to `end` never allocates
+ *
+ * The arena is not thread-safe, so -j calls this before the threads record.
+ */
+void timeline_reserve(Timeline *timeline, int end) {
+    while (end > timeline->capacity) {
+        expand_timeline(timeline, timeline->capacity * 2);
+    }
+    if (timeline->storage != TIMELINE_RLE) return;
+    for (int c = 0; c < timeline->cpu_count; c++) {
+        if (timeline->segment_counts[c] >= timeline->segment_capacities[c]) grow_timeline_segments(timeline, c);
+    }
+}
+
+/**
+ * Look up the PID on `cpu` at time `t` (-1 if idle or never recorded)
+ *
+ * For RLE storage `cursor` remembers the segment last used on this CPU so a
+ * left-to-right walk is amortized O(1) per lookup; start it at 0.
+ */
+int timeline_pid_at(const Timeline *timeline, int cpu, int t, int *cursor) {
+    if (timeline->storage == TIMELINE_GRID) {
+        if (t >= timeline->capacity) return -1;
+        return timeline->cells[(size_t)t * timeline->cpu_count + cpu];
+    }
+    if (timeline->storage == TIMELINE_NONE) return -1;
+
+    const TimelineSegment *segs = timeline->segments[cpu];
+    int count = timeline->segment_counts[cpu];
+    if (*cursor >= count || (*cursor > 0 && segs[*cursor].start > t)) *cursor = 0;
+    while (*cursor < count && segs[*cursor].end <= t) (*cursor)++;
+    if (*cursor < count && segs[*cursor].start <= t) return segs[*cursor].pid;
+    return -1;
+}
+
+/**
+ * Lookup cursor for `cpu` positioned at time `t`
+ *
+ * For RLE storage this binary-searches the first segment that ends after `t`,
+ * so printing a window never walks the segments before it.
+ */
+int timeline_seek(const Timeline *timeline, int cpu, int t) {
+    if (timeline->storage != TIMELINE_RLE) return 0;
+    const TimelineSegment *segs = timeline->segments[cpu];
+    int lo = 0, hi = timeline->segment_counts[cpu];
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (segs[mid].end <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Store the PID on `cpu` at time `t` in `pid` and return where that run ends, at most `limit`
+ *
+ * RLE storage answers from the segment bounds; the grid is scanned cell by cell.
+ */
+int timeline_run_end(const Timeline *timeline, int cpu, int t, int limit, int *cursor, int *pid) {
+    *pid = timeline_pid_at(timeline, cpu, t, cursor);
+    if (timeline->storage == TIMELINE_RLE) {
+        const TimelineSegment *segs = timeline->segments[cpu];
+        int count = timeline->segment_counts[cpu];
+        int end = limit;
+        if (*cursor < count) end = *pid == -1 ? segs[*cursor].start : segs[*cursor].end;
+        if (end <= t) end = t + 1; // Overlapping segments: advance one unit
+        return end < limit ? end : limit;
+    }
+    int end = t + 1;
+    while (end < limit && timeline_pid_at(timeline, cpu, end, cursor) == *pid) end++;
+    return end;
+}
+
+/**
+ * Clean up the timeline data structure (the arena reclaims its storage)
+ */
+void cleanup_timeline(Timeline *timeline) {
+    timeline->cells = NULL;
+    timeline->segments = NULL;
+    timeline->segment_counts = NULL;
+    timeline->segment_capacities = NULL;
+}
+
+/************************* HELPER FUNCTIONS *************************/
+
+/**
+ * Get a color code for a process ID for colorized output
+ */
+const char* get_color_for_pid(int pid) {
+    if (pid < 0) return COLOR_RESET; // Idle
+    return PROCESS_COLORS[pid % NUM_PROCESS_COLORS];
+}
+
+/**
+ * Get the short command line code for an algorithm (as given to -a)
+ */
+const char* algorithm_code(Algorithm algorithm) {
+    switch (algorithm) {
+        case FCFS: return "FCFS";
+        case RR:   return "RR";
+        case SRTF: return "SRTF";
+        case SJF:  return "SJF";
+        case MLFQ: return "MLFQ";
+        case PRIO: return "PRIO";
+        case PPRIO: return "PPRIO";
+        default:   return "UNKNOWN";
+    }
+}
+
+/**
+ * Whether -q applies to an algorithm (RR, and the top level of MLFQ)
+ */
+bool algorithm_uses_quantum(Algorithm algorithm) {
+    return algorithm == RR || algorithm == MLFQ;
+}
+
+/**
+ * Whether an algorithm only runs on the single global ready queue
+ */
+bool algorithm_needs_global_queue(Algorithm algorithm) {
+    return algorithm == MLFQ || algorithm == PRIO || algorithm == PPRIO;
+}
+
+/**
+ * Get the --runqueues name of a placement policy
+ */
+const char* placement_name(QueuePlacement placement) {
+    switch (placement) {
+        case PLACE_GLOBAL:       return "global";
+        case PLACE_ROUND_ROBIN:  return "rr";
+        case PLACE_LEAST_LOADED: return "least";
+        default:                 return "unknown";
+    }
+}
+
+/**
+ * Get the algorithm name as a string
+ */
+const char* algorithm_name(Algorithm algorithm) {
+    switch (algorithm) {
+        case FCFS: return "First-Come, First-Served";
+        case RR:   return "Round Robin";
+        case SRTF: return "Shortest Remaining Time First";
+        case SJF:  return "Shortest Job First";
+        case MLFQ: return "Multilevel Feedback Queue";
+        case PRIO: return "Priority (non-preemptive)";
+        case PPRIO: return "Priority (preemptive)";
+        default:   return "Unknown Algorithm";
+    }
+}
+
+/**
+ * Append a value to a growable int list
+ */
+void int_list_push(IntList *list, int value) {
+    if (list->count >= list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 8;
+        int *temp = (int *)realloc(list->values, new_capacity * sizeof(int));
+        if (!temp) {
+            perror("Failed to grow option list");
+            exit(EXIT_FAILURE);
+        }
+        list->values = temp;
+        list->capacity = new_capacity;
+    }
+    list->values[list->count++] = value;
+}
+
+/**
+ * Release an int list
+ */
+void free_int_list(IntList *list) {
+    free(list->values);
+    list->values = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * Append a string to a growable string list
+ */
+void string_list_push(StringList *list, char *value) {
+    if (list->count >= list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 8;
+        char **temp = (char **)realloc(list->values, new_capacity * sizeof(char *));
+        if (!temp) {
+            perror("Failed to grow file list");
+            exit(EXIT_FAILURE);
+        }
+        list->values = temp;
+        list->capacity = new_capacity;
+    }
+    list->values[list->count++] = value;
+}
+
+/**
+ * Release a string list, and its strings if the list owns them
+ */
+void free_string_list(StringList *list, bool owned) {
+    if (owned) {
+        for (int i = 0; i < list->count; i++) free(list->values[i]);
+    }
+    free(list->values);
+    list->values = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * Map an algorithm name (FCFS, RR, SRTF, SJF, MLFQ, PRIO, PPRIO) to its identifier
+ */
+bool parse_algorithm_name(const char *name, Algorithm *algorithm) {
+    if (strcmp(name, "FCFS") == 0) *algorithm = FCFS;
+    else if (strcmp(name, "RR") == 0) *algorithm = RR;
+    else if (strcmp(name, "SRTF") == 0) *algorithm = SRTF;
+    else if (strcmp(name, "SJF") == 0) *algorithm = SJF;
+    else if (strcmp(name, "MLFQ") == 0) *algorithm = MLFQ;
+    else if (strcmp(name, "PRIO") == 0) *algorithm = PRIO;
+    else if (strcmp(name, "PPRIO") == 0) *algorithm = PPRIO;
+    else return false;
+    return true;
+}
+
+/**
+ * Parse a comma-separated algorithm list such as "FCFS,RR"
+ *
+ * False if any entry is not an algorithm name (or the list is empty), in
+ * which case the list is left as it was.
+ */
+bool parse_algorithm_list(const char *arg, IntList *list) {
+    char buffer[MAX_LINE_LENGTH];
+    IntList parsed = {NULL, 0, 0};
+
+    const char *p = arg;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        Algorithm algorithm;
+        if (len >= sizeof(buffer)) {
+            free_int_list(&parsed);
+            return false;
+        }
+        memcpy(buffer, p, len);
+        buffer[len] = '\0';
+        if (!parse_algorithm_name(buffer, &algorithm)) {
+            free_int_list(&parsed);
+            return false;
+        }
+        int_list_push(&parsed, algorithm);
+        p += len;
+        if (*p == ',') p++;
+    }
+
+    if (parsed.count == 0) return false;
+    free_int_list(list);
+    *list = parsed;
+    return true;
+}
+
+/**
+ * Parse a list of positive integers such as "4", "1,2,8" or "1..16"
+ *
+ * Values that are not positive are replaced by `fallback`, matching how a
+ * single -c/-q value has always been sanitized. Returns false on a
+ * descending range.
+ */
+bool parse_int_list(const char *arg, IntList *list, int fallback) {
+    list->count = 0;
+
+    const char *p = arg;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (strncmp(end, "..", 2) == 0) {
+            hi = strtol(end + 2, &end, 10);
+            if (hi < lo) return false;
+        }
+        if (lo == hi) {
+            int_list_push(list, lo > 0 && lo <= INT_MAX ? (int)lo : fallback);
+        } else {
+            if (lo < 1) lo = 1;
+            for (long v = lo; v <= hi && v <= INT_MAX; v++) int_list_push(list, (int)v);
+        }
+        p = end + strcspn(end, ",");
+        if (*p == ',') p++;
+    }
+
+    if (list->count == 0) int_list_push(list, fallback);
+    return true;
+}
+
+/**
+ * Parse a "<start>:<end>" time window; either bound may be left out ("100:", ":50")
+ */
+bool parse_time_window(const char *arg, TimelineWindow *window) {
+    const char *colon = strchr(arg, ':');
+    if (!colon) return false;
+    char *end;
+    long start = 0, stop = -1;
+    if (colon != arg) {
+        start = strtol(arg, &end, 10);
+        if (end != colon || start < 0 || start > INT_MAX) return false;
+    }
+    if (colon[1] != '\0') {
+        stop = strtol(colon + 1, &end, 10);
+        if (*end != '\0' || stop < start || stop > INT_MAX) return false;
+    }
+    window->start = (int)start;
+    window->end = (int)stop;
+    return true;
+}
+
+/**
+ * Parse a comma-separated output selection such as "csv" or "summary,csv"
+ */
+bool parse_output_list(const char *arg, unsigned *output) {
+    unsigned selected = 0;
+
+    const char *p = arg;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        if (len == 3 && strncmp(p, "csv", len) == 0) selected |= OUTPUT_CSV;
+        else if (len == 7 && strncmp(p, "summary", len) == 0) selected |= OUTPUT_SUMMARY;
+        else if (len == 8 && strncmp(p, "timeline", len) == 0) selected |= OUTPUT_TIMELINE;
+        else if (len == 3 && strncmp(p, "all", len) == 0) selected |= OUTPUT_ALL;
+        else return false;
+        p += len;
+        if (*p == ',') p++;
+    }
+
+    if (selected == 0) return false;
+    *output = selected;
+    return true;
+}
+
+/**
+ * Parse command line arguments
+ *
+ * -a, -c and -q accept lists ("FCFS,RR", "1,2,4", "1..16"); more than one
+ * value in any of them (or --sweep) selects sweep mode.
+ */
+void parse_arguments(int argc, char *argv[], Options *opts) {
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            ok = parse_algorithm_list(argv[++i], &opts->algorithms);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            ok = parse_int_list(argv[++i], &opts->cpu_counts, 1); // Ensure at least 1 CPU
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            ok = parse_int_list(argv[++i], &opts->quanta, DEFAULT_TIME_QUANTUM);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            string_list_push(&opts->input_files, argv[++i]);
+            if (!opts->input_file) opts->input_file = argv[i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "tick") == 0) opts->mode = SIM_TICK;
+            else if (strcmp(argv[i], "event") == 0) opts->mode = SIM_EVENT;
+            else ok = false;
+        } else if (strcmp(argv[i], "--timeline") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "grid") == 0) opts->storage = TIMELINE_GRID;
+            else if (strcmp(argv[i], "rle") == 0) opts->storage = TIMELINE_RLE;
+            else if (strcmp(argv[i], "none") == 0) opts->storage = TIMELINE_NONE;
+            else ok = false;
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            ok = parse_output_list(argv[++i], &opts->output);
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            opts->stream = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            opts->stats = true;
+        } else if (strcmp(argv[i], "--percentiles") == 0) {
+            opts->percentiles = true;
+        } else if (strcmp(argv[i], "--runqueues") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "global") == 0) opts->placement = PLACE_GLOBAL;
+            else if (strcmp(argv[i], "rr") == 0) opts->placement = PLACE_ROUND_ROBIN;
+            else if (strcmp(argv[i], "least") == 0) opts->placement = PLACE_LEAST_LOADED;
+            else ok = false;
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            opts->sweep = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts->threads = atoi(argv[++i]);
+            if (opts->threads < 1) opts->threads = 1;
+        } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc) {
+            opts->aging = atoi(argv[++i]);
+            if (opts->aging < 0) opts->aging = 0;
+        } else if (strcmp(argv[i], "--switch-cost") == 0 && i + 1 < argc) {
+            opts->switch_cost = atoi(argv[++i]);
+            if (opts->switch_cost < 0) opts->switch_cost = 0;
+        } else if (strcmp(argv[i], "--migration-cost") == 0 && i + 1 < argc) {
+            opts->migration_cost = atoi(argv[++i]);
+            if (opts->migration_cost < 0) opts->migration_cost = 0;
+        } else if (strcmp(argv[i], "--max-time") == 0 && i + 1 < argc) {
+            opts->max_time = atoi(argv[++i]);
+            if (opts->max_time < 0) opts->max_time = 0;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            opts->trace = true;
+        } else if (strcmp(argv[i], "--affinity") == 0 && i + 1 < argc) {
+            opts->affinity = atoi(argv[++i]);
+            ok = opts->affinity >= 0; // -1 means off, so it cannot be a wait threshold
+        } else if (strcmp(argv[i], "--write-binary") == 0 && i + 1 < argc) {
+            opts->binary_out = argv[++i];
+        } else if (strcmp(argv[i], "--write-text") == 0 && i + 1 < argc) {
+            opts->text_out = argv[++i];
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            opts->dump_file = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            opts->replay_file = argv[++i];
+        } else if (strcmp(argv[i], "--timeline-window") == 0 && i + 1 < argc) {
+            ok = parse_time_window(argv[++i], &opts->window);
+        } else if (strcmp(argv[i], "--timeline-summary") == 0 && i + 1 < argc) {
+            opts->window.bucket = atoi(argv[++i]);
+            if (opts->window.bucket < 1) opts->window.bucket = 1;
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            opts->checkpoint_file = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            opts->checkpoint_interval = atoi(argv[++i]);
+            if (opts->checkpoint_interval < 1) opts->checkpoint_interval = 1;
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            opts->resume_file = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            opts->workers = atoi(argv[++i]);
+            if (opts->workers < 0) opts->workers = 0;
+        } else if (opts->input_file && argv[i][0] != '-') {
+            string_list_push(&opts->input_files, argv[i]); // More files of a glob such as -f traces/*.txt
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Usage: %s -f <file|dir> [<file> ...] [-f ...] [-a <FCFS|RR|SRTF|SJF|MLFQ|PRIO|PPRIO>[,...]] [-c <cpus>] [-q <quantum>] "
+                            "[-m <tick|event>] [--timeline <grid|rle|none>] [--sweep] [--workers <n>] [--stream] [--stats] [--percentiles]\n"
+                            "       [--output <csv|summary|timeline|all>[,...]] [--runqueues <global|rr|least>] [-j <threads>] [--aging <n>]\n"
+                            "       [--switch-cost <n>] [--migration-cost <n>] [--affinity <wait>] [--max-time <n>] [--trace]\n"
+                            "       [--write-binary <out>] [--write-text <out>] [--dump <results>]\n"
+                            "       [--timeline-window <start>:<end>] [--timeline-summary <units per column>]\n"
+                            "       [--checkpoint <out>] [--checkpoint-every <n>] [--resume <checkpoint>]\n"
+                            "       %s --replay <results> [--output ...]\n"
+                            "       -c and -q take a value, a list (1,2,4) or a range (1..16)\n", argv[0], argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Fill in defaults for anything not given
+    if (opts->algorithms.count == 0) int_list_push(&opts->algorithms, FCFS);
+    if (opts->cpu_counts.count == 0) int_list_push(&opts->cpu_counts, 1);
+    if (opts->quanta.count == 0) int_list_push(&opts->quanta, DEFAULT_TIME_QUANTUM);
+
+    if (opts->algorithms.count > 1 || opts->cpu_counts.count > 1 || opts->quanta.count > 1) {
+        opts->sweep = true;
+    }
+
+    // Several workloads, or a directory of them, run as one sweep over every file
+    struct stat st;
+    if (opts->input_files.count > 1 ||
+        (opts->input_files.count == 1 && stat(opts->input_file, &st) == 0 && S_ISDIR(st.st_mode))) {
+        for (int f = 0; f < opts->input_files.count; f++) {
+            if (strcmp(opts->input_files.values[f], "-") == 0) {
+                fprintf(stderr, "Error: stdin (-f -) cannot be one of several -f workloads\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (opts->stream || opts->binary_out || opts->text_out) {
+            fprintf(stderr, "Error: --stream, --write-binary and --write-text take a single -f <file>\n");
+            exit(EXIT_FAILURE);
+        }
+        opts->batch = true;
+        opts->sweep = true;
+    }
+
+    for (int a = 0; a < opts->algorithms.count; a++) {
+        Algorithm algorithm = (Algorithm)opts->algorithms.values[a];
+        if (algorithm_needs_global_queue(algorithm) && opts->placement != PLACE_GLOBAL) {
+            fprintf(stderr, "Error: %s runs on the global ready queue and cannot be combined with --runqueues\n",
+                    algorithm_code(algorithm));
+            exit(EXIT_FAILURE);
+        }
+        if (opts->affinity >= 0 && (algorithm == MLFQ || opts->placement != PLACE_GLOBAL)) {
+            fprintf(stderr, "Error: --affinity dispatches from the global ready queue and cannot be combined "
+                            "with MLFQ or --runqueues\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (opts->input_file && strcmp(opts->input_file, "-") == 0) opts->stream = true;
+    if (opts->stream && opts->sweep) {
+        fprintf(stderr, "Error: stream input (-f - or --stream) cannot be combined with a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->stream && (opts->binary_out || opts->text_out || opts->dump_file)) {
+        fprintf(stderr, "Error: --write-binary, --write-text and --dump need a loaded -f <file>, not stream input\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->dump_file && (opts->stats || opts->percentiles || opts->placement != PLACE_GLOBAL)) {
+        fprintf(stderr, "Error: --dump does not record --stats, --percentiles or --runqueues statistics; "
+                        "run without --dump for those\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->sweep && opts->dump_file) {
+        fprintf(stderr, "Error: --dump records a single run and cannot be combined with a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((opts->stream || opts->sweep) && (opts->checkpoint_file || opts->resume_file)) {
+        fprintf(stderr, "Error: --checkpoint and --resume need a single run of a loaded -f <file>\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->sweep && opts->trace) {
+        fprintf(stderr, "Error: --trace follows a single run and cannot be combined with a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->sweep && opts->percentiles) {
+        fprintf(stderr, "Error: --percentiles reports a single run and cannot be combined with a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->resume_file && (opts->stats || opts->percentiles)) {
+        fprintf(stderr, "Error: --stats and --percentiles cannot be combined with --resume\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->replay_file) return; // Replaying needs no workload
+
+    if (!(opts->input_file)) {
+        fprintf(stderr, "Error: Input file required. Use -f <filename>\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+
+/************************* PROCESS LOADING *************************/
+
+/**
+ * Fill in a freshly loaded process
+ */
+void init_process(Process *p, int pid, int arrival, int burst, int priority) {
+    p->pid = pid;
+    p->arrival_time = arrival;
+    p->burst_time = burst;
+    p->priority = priority;
+    p->remaining_time = burst;
+    p->state = WAITING;
+    p->start_time = -1;
+    p->finish_time = -1;
+    p->waiting_time = 0;
+    p->ready_since = -1;
+    p->quantum_used = 0;
+    p->level = 0;
+    p->aged = 0;
+    p->aging_due = -1;
+    p->response_time = -1;
+    p->last_cpu = -1;
+}
+
+/**
+ * Append a process to a growable array, doubling its capacity when full
+ */
+void append_process(Process **processes_ptr, int *count, int *capacity,
+                    int pid, int arrival, int burst, int priority) {
+    if (*count >= *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 1024;
+        Process *temp = (Process *)realloc(*processes_ptr, new_capacity * sizeof(Process));
+        if (!temp) {
+            perror("Memory allocation failed for processes");
+            exit(EXIT_FAILURE);
+        }
+        *processes_ptr = temp;
+        *capacity = new_capacity;
+    }
+    init_process(&(*processes_ptr)[*count], pid, arrival, burst, priority);
+    (*count)++;
+}
+
+/**
+ * Read one integer from [*p, end), skipping leading blanks like "%d" does
+ *
+ * Accepts an optional sign followed by at least one digit. On success the
+ * cursor moves past the number.
+ */
+bool parse_int_token(const char **p, const char *end, int *value) {
+    const char *s = *p;
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\v' || *s == '\f')) s++;
+
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = (*s == '-');
+        s++;
+    }
+    if (s >= end || *s < '0' || *s > '9') return false;
+
+    long v = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        if (v <= INT_MAX) v = v * 10 + (*s - '0');
+        s++;
+    }
+    if (v > INT_MAX) v = INT_MAX;
+    *value = (int)(negative ? -v : v);
+    *p = s;
+    return true;
+}
+
+/**
+ * Parse one "<PID> <arrival_time> <burst_time> [priority]" line
+ *
+ * Returns the number of leading integers read (at most 4), so callers apply
+ * the same ">= 3" rule the sscanf-based loader used. Comment lines read as 0.
+ */
+int parse_process_line(const char *line, const char *end, int fields[4]) {
+    if (line < end && line[0] == '#') return 0;
+
+    int items = 0;
+    const char *p = line;
+    while (items < 4 && parse_int_token(&p, end, &fields[items])) items++;
+    return items;
+}
+
+/**
+ * Parse every process line in a memory buffer and append it to the array
+ */
+void parse_process_buffer(const char *data, size_t size, Process **processes_ptr, int *count, int *capacity) {
+    const char *p = data;
+    const char *end = data + size;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+
+        int fields[4];
+        int items = parse_process_line(p, eol, fields);
+        if (items >= 3) { // Need at least PID, arrival, burst
+            append_process(processes_ptr, count, capacity, fields[0], fields[1], fields[2],
+                           (items == 4) ? fields[3] : 0); // Assign priority if read
+        }
+        p = eol + 1;
+    }
+}
+
+/**
+ * Decode a loaded workload, binary if it starts with WORKLOAD_MAGIC and text otherwise
+ */
+void load_process_data(const char *data, size_t size, const char *filename,
+                       Process **processes_ptr, int *count, int *capacity) {
+    if (is_binary_workload(data, size)) {
+        decode_binary_workload(data, size, filename, processes_ptr, count, capacity);
+    } else {
+        parse_process_buffer(data, size, processes_ptr, count, capacity);
+    }
+}
+
+/**
+ * Load processes from a file, exiting if it cannot be opened
+ * 
+ * Expected format:
+ * <PID> <arrival_time> <burst_time> [priority]
+ * 
+ * Lines starting with # are treated as comments. A binary workload (see
+ * write_binary_workload()) is recognized by its header and decoded directly.
+ *
+ * Regular files are memory-mapped and parsed in a single pass; anything that
+ * cannot be mapped (pipes, devices) is read in large blocks first. Lines may
+ * be of any length.
+ */
+void load_processes(const char *filename, Process **processes_ptr, int *count) {
+    if (!read_process_file(filename, processes_ptr, count)) {
+        perror("Error opening process file");
+        exit(EXIT_FAILURE);
+    }
+    if (*count == 0) printf("Warning: No valid processes found in %s\n", filename);
+}
+
+/**
+ * Read every process record of a file; false (with errno set) if it cannot be opened
+ *
+ * Prints nothing, so the library can use it too.
+ */
+bool read_process_file(const char *filename, Process **processes_ptr, int *count) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    Process *processes = NULL;
+    int process_count = 0;
+    int capacity = 0;
+
+    struct stat st;
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (mapped != MAP_FAILED) {
+        load_process_data((const char *)mapped, (size_t)st.st_size, filename, &processes, &process_count, &capacity);
+        munmap(mapped, (size_t)st.st_size);
+    } else {
+        size_t size = 0, buffer_capacity = LOAD_BLOCK_SIZE;
+        char *buffer = (char *)malloc(buffer_capacity);
+        if (!buffer) {
+            perror("Memory allocation failed for process file");
+            close(fd);
+            exit(EXIT_FAILURE);
+        }
+        while (true) {
+            if (size == buffer_capacity) {
+                buffer_capacity *= 2;
+                char *temp = (char *)realloc(buffer, buffer_capacity);
+                if (!temp) {
+                    perror("Memory allocation failed for process file");
+                    close(fd);
+                    exit(EXIT_FAILURE);
+                }
+                buffer = temp;
+            }
+            ssize_t n = read(fd, buffer + size, buffer_capacity - size);
+            if (n < 0) {
+                perror("Error reading process file");
+                close(fd);
+                exit(EXIT_FAILURE);
+            }
+            if (n == 0) break;
+            size += (size_t)n;
+        }
+        load_process_data(buffer, size, filename, &processes, &process_count, &capacity);
+        free(buffer);
+    }
+    close(fd);
+
+    if (process_count == 0) {
+        free(processes);
+        *processes_ptr = NULL;
+        *count = 0;
+        return true;
+    }
+
+    *processes_ptr = processes;
+    *count = process_count; // Actual number of processes successfully read
+    return true;
+}
+
+/**
+ * Order two arrival entries by arrival time, then by position in the input
+ */
+int compare_arrival_entries(const void *a, const void *b) {
+    const ArrivalEntry *x = (const ArrivalEntry *)a;
+    const ArrivalEntry *y = (const ArrivalEntry *)b;
+    if (x->arrival_time != y->arrival_time) return (x->arrival_time < y->arrival_time) ? -1 : 1;
+    return (x->idx < y->idx) ? -1 : (x->idx > y->idx);
+}
+
+/**
+ * Count the places where an arrival time is smaller than the one before it
+ *
+ * Branch-free over a dense array so it vectorizes; zero means the input is
+ * already in arrival order.
+ */
+static SIMD_CLONES int count_descents(const int *keys, int n) {
+    int descents = 0;
+    for (int i = 1; i < n; i++) descents += keys[i] < keys[i - 1];
+    return descents;
+}
+
+/**
+ * Stable LSD radix sort of arrival entries by arrival time
+ *
+ * One pass per byte of the key, skipping bytes every key shares (arrivals
+ * rarely need more than two). Stability keeps equal arrivals in input order,
+ * matching compare_arrival_entries().
+ */
+void radix_sort_arrivals(ArrivalEntry *entries, int n) {
+    ArrivalEntry *scratch = (ArrivalEntry *)malloc(n * sizeof(ArrivalEntry));
+    if (!scratch) {
+        perror("Failed to allocate arrival index");
+        exit(EXIT_FAILURE);
+    }
+
+    ArrivalEntry *src = entries;
+    ArrivalEntry *dst = scratch;
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t counts[256] = {0};
+        for (int i = 0; i < n; i++) {
+            // Flip the sign bit so negative times sort first
+            unsigned int key = (unsigned int)src[i].arrival_time ^ 0x80000000u;
+            counts[(key >> shift) & 0xFF]++;
+        }
+        unsigned int first = ((unsigned int)src[0].arrival_time ^ 0x80000000u) >> shift & 0xFF;
+        if (counts[first] == (size_t)n) continue; // Every key has this byte
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = counts[b];
+            counts[b] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < n; i++) {
+            unsigned int key = (unsigned int)src[i].arrival_time ^ 0x80000000u;
+            dst[counts[(key >> shift) & 0xFF]++] = src[i];
+        }
+        ArrivalEntry *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != entries) memcpy(entries, src, n * sizeof(ArrivalEntry));
+    free(scratch);
+}
+
+/**
+ * Build an index of the process array sorted by arrival time
+ *
+ * Processes arriving at the same time keep their input order, so the arrival
+ * stage sees them in exactly the order a full scan would. Inputs that are
+ * already sorted (the usual case) get the identity order without sorting;
+ * large unsorted ones use a radix sort. The index is taken from `arena`.
+ */
+int *build_arrival_order(Process *processes, int process_count, Arena *arena) {
+    int *order = (int *)arena_alloc(arena, process_count * sizeof(int));
+
+    // Gather the arrival times into a dense array for the scan
+    for (int i = 0; i < process_count; i++) order[i] = processes[i].arrival_time;
+    if (process_count < 2 || count_descents(order, process_count) == 0) {
+        for (int i = 0; i < process_count; i++) order[i] = i;
+        return order;
+    }
+
+    ArrivalEntry *entries = (ArrivalEntry *)malloc(process_count * sizeof(ArrivalEntry));
+    if (!entries) {
+        perror("Failed to allocate arrival index");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < process_count; i++) {
+        entries[i].arrival_time = processes[i].arrival_time;
+        entries[i].idx = i;
+    }
+    if (process_count < RADIX_SORT_MIN) {
+        qsort(entries, process_count, sizeof(ArrivalEntry), compare_arrival_entries);
+    } else {
+        radix_sort_arrivals(entries, process_count);
+    }
+    for (int i = 0; i < process_count; i++) order[i] = entries[i].idx;
+
+    free(entries);
+    return order;
+}
+
+/************************* BINARY TRACES *************************/
+
+/**
+ * Convert a 32-bit value between little-endian file order and host order
+ */
+uint32_t le32(uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+/**
+ * Convert a 64-bit value between little-endian file order and host order
+ */
+uint64_t le64(uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(value);
+#else
+    return value;
+#endif
+}
+
+/**
+ * Whether a buffer starts with the binary workload magic
+ */
+bool is_binary_workload(const void *data, size_t size) {
+    return size >= BINARY_MAGIC_LENGTH && memcmp(data, WORKLOAD_MAGIC, BINARY_MAGIC_LENGTH) == 0;
+}
+
+/**
+ * Read the PID, arrival, burst and priority of one binary workload record
+ */
+void decode_workload_record(const void *record, int fields[4]) {
+    const WorkloadRecord *r = (const WorkloadRecord *)record;
+    fields[0] = (int32_t)le32((uint32_t)r->pid);
+    fields[1] = (int32_t)le32((uint32_t)r->arrival_time);
+    fields[2] = (int32_t)le32((uint32_t)r->burst_time);
+    fields[3] = (int32_t)le32((uint32_t)r->priority);
+}
+
+/**
+ * Fill a process array straight from a binary workload held in memory
+ *
+ * `data` is the mapped file, so the records are read in place: there is no
+ * tokenizing and the array is allocated once at its final size.
+ */
+void decode_binary_workload(const void *data, size_t size, const char *filename,
+                            Process **processes_ptr, int *count, int *capacity) {
+    const WorkloadHeader *header = (const WorkloadHeader *)data;
+    size_t record_size = size >= sizeof(WorkloadHeader) ? le32(header->record_size) : 0;
+    uint64_t record_count = record_size ? le64(header->record_count) : 0;
+    if (record_size < sizeof(WorkloadRecord) || record_size % sizeof(int32_t) != 0 ||
+        record_count > INT_MAX || record_count > (size - sizeof(WorkloadHeader)) / record_size) {
+        fprintf(stderr, "Error: %s is not a valid binary workload (truncated or bad header)\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    if (record_count == 0) return;
+
+    int n = (int)record_count;
+    Process *processes = (Process *)malloc((size_t)n * sizeof(Process));
+    if (!processes) {
+        perror("Memory allocation failed for processes");
+        exit(EXIT_FAILURE);
+    }
+
+    const char *record = (const char *)data + sizeof(WorkloadHeader);
+    for (int i = 0; i < n; i++, record += record_size) {
+        int fields[4];
+        decode_workload_record(record, fields);
+        init_process(&processes[i], fields[0], fields[1], fields[2], fields[3]);
+    }
+
+    *processes_ptr = processes;
+    *count = n;
+    *capacity = n;
+}
+
+/**
+ * Open a file for writing ("-" means standard output)
+ */
+FILE *open_output_file(const char *filename) {
+    if (strcmp(filename, "-") == 0) return stdout;
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        perror("Error opening output file");
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+/**
+ * Flush and close a file from open_output_file(), failing on any write error
+ */
+void close_output_file(FILE *f, const char *filename) {
+    bool failed = ferror(f) != 0;
+    if (f == stdout) failed |= fflush(f) != 0;
+    else failed |= fclose(f) != 0;
+    if (failed) {
+        fprintf(stderr, "Error: failed writing %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Write processes as a binary workload (--write-binary)
+ */
+void write_binary_workload(const char *filename, const Process *processes, int process_count) {
+    FILE *f = open_output_file(filename);
+
+    WorkloadHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORKLOAD_MAGIC, BINARY_MAGIC_LENGTH);
+    header.record_size = le32(sizeof(WorkloadRecord));
+    header.record_count = le64((uint64_t)process_count);
+    fwrite(&header, sizeof(header), 1, f);
+
+    for (int i = 0; i < process_count; i++) {
+        WorkloadRecord r;
+        r.pid = (int32_t)le32((uint32_t)processes[i].pid);
+        r.arrival_time = (int32_t)le32((uint32_t)processes[i].arrival_time);
+        r.burst_time = (int32_t)le32((uint32_t)processes[i].burst_time);
+        r.priority = (int32_t)le32((uint32_t)processes[i].priority);
+        fwrite(&r, sizeof(r), 1, f);
+    }
+    close_output_file(f, filename);
+}
+
+/**
+ * Write processes in the "<PID> <arrival> <burst> <priority>" text format (--write-text)
+ */
+void write_text_workload(const char *filename, const Process *processes, int process_count) {
+    FILE *f = open_output_file(filename);
+    fprintf(f, "# PID Arrival Burst Priority\n");
+    for (int i = 0; i < process_count; i++) {
+        fprintf(f, "%d %d %d %d\n", processes[i].pid, processes[i].arrival_time,
+                processes[i].burst_time, processes[i].priority);
+    }
+    close_output_file(f, filename);
+}
+
+/**
+ * Write the busy stretches of a timeline, by CPU then time; returns how many
+ *
+ * Works the same for grid and RLE storage, so a dump does not depend on the
+ * layout. With `f` NULL the runs are only counted.
+ */
+uint64_t write_timeline_runs(const Timeline *timeline, int total_time, FILE *f) {
+    uint64_t runs = 0;
+    for (int c = 0; c < timeline->cpu_count; c++) {
+        int cursor = 0;
+        int t = 0;
+        while (t < total_time) {
+            int pid = timeline_pid_at(timeline, c, t, &cursor);
+            int start = t;
+            while (t < total_time && timeline_pid_at(timeline, c, t, &cursor) == pid) t++;
+            if (pid == -1) continue;
+            runs++;
+            if (f) {
+                ResultsSegmentRecord r;
+                r.cpu = (int32_t)le32((uint32_t)c);
+                r.pid = (int32_t)le32((uint32_t)pid);
+                r.start = (int32_t)le32((uint32_t)start);
+                r.end = (int32_t)le32((uint32_t)t);
+                fwrite(&r, sizeof(r), 1, f);
+            }
+        }
+    }
+    return runs;
+}
+
+/**
+ * Write the final state of a finished run as a binary results dump (--dump)
+ */
+void dump_results(const char *filename, const SimulationContext *ctx) {
+    FILE *f = open_output_file(filename);
+
+    ResultsHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESULTS_MAGIC, BINARY_MAGIC_LENGTH);
+    header.algorithm = (int32_t)le32((uint32_t)ctx->algorithm);
+    header.cpu_count = (int32_t)le32((uint32_t)ctx->cpu_count);
+    header.time_quantum = (int32_t)le32((uint32_t)ctx->time_quantum);
+    header.total_time = (int32_t)le32((uint32_t)ctx->total_time);
+    header.has_timeline = (int32_t)le32(ctx->timeline.storage != TIMELINE_NONE);
+    header.locality = (int32_t)le32(ctx->affinity_wait >= 0 || ctx->migration_cost > 0);
+    header.process_count = le64((uint64_t)ctx->process_count);
+    header.segment_count = le64(write_timeline_runs(&ctx->timeline, ctx->total_time, NULL));
+    fwrite(&header, sizeof(header), 1, f);
+
+    for (int i = 0; i < ctx->process_count; i++) {
+        const Process *p = &ctx->processes[i];
+        ResultsProcessRecord r;
+        r.pid = (int32_t)le32((uint32_t)p->pid);
+        r.arrival_time = (int32_t)le32((uint32_t)p->arrival_time);
+        r.burst_time = (int32_t)le32((uint32_t)p->burst_time);
+        r.priority = (int32_t)le32((uint32_t)p->priority);
+        r.start_time = (int32_t)le32((uint32_t)p->start_time);
+        r.finish_time = (int32_t)le32((uint32_t)p->finish_time);
+        r.waiting_time = (int32_t)le32((uint32_t)p->waiting_time);
+        r.response_time = (int32_t)le32((uint32_t)p->response_time);
+        fwrite(&r, sizeof(r), 1, f);
+    }
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        ResultsCpuRecord r;
+        r.id = (int32_t)le32((uint32_t)ctx->cpus[c].id);
+        r.busy_time = (int32_t)le32((uint32_t)ctx->cpus[c].busy_time);
+        r.idle_time = (int32_t)le32((uint32_t)ctx->cpus[c].idle_time);
+        r.overhead_time = (int32_t)le32((uint32_t)ctx->cpus[c].overhead_time);
+        r.same_cpu_dispatches = (int32_t)le32((uint32_t)ctx->cpus[c].same_cpu_dispatches);
+        r.migrated_dispatches = (int32_t)le32((uint32_t)ctx->cpus[c].migrated_dispatches);
+        fwrite(&r, sizeof(r), 1, f);
+    }
+    write_timeline_runs(&ctx->timeline, ctx->total_time, f);
+    close_output_file(f, filename);
+}
+
+/**
+ * Print a results dump through the normal printers (--replay)
+ *
+ * The dump is memory-mapped and read in place; `--output csv` turns it back
+ * into the same CSV blocks the original run printed.
+ */
+void replay_results(const char *filename, unsigned output, const TimelineWindow *window) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening results dump");
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: %s is not a regular file\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    size_t size = (size_t)st.st_size;
+    void *mapped = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    const ResultsHeader *header = (const ResultsHeader *)mapped;
+    if (mapped == MAP_FAILED || size < sizeof(ResultsHeader) ||
+        memcmp(header->magic, RESULTS_MAGIC, BINARY_MAGIC_LENGTH) != 0) {
+        fprintf(stderr, "Error: %s is not a results dump\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    Algorithm algorithm = (Algorithm)(int32_t)le32((uint32_t)header->algorithm);
+    int cpu_count = (int32_t)le32((uint32_t)header->cpu_count);
+    int time_quantum = (int32_t)le32((uint32_t)header->time_quantum);
+    int total_time = (int32_t)le32((uint32_t)header->total_time);
+    uint64_t process_count = le64(header->process_count);
+    uint64_t segment_count = le64(header->segment_count);
+    size_t body = size - sizeof(ResultsHeader);
+    if (cpu_count < 1 || total_time < 0 || process_count > INT_MAX ||
+        process_count > body / sizeof(ResultsProcessRecord) ||
+        (size_t)cpu_count > (body - process_count * sizeof(ResultsProcessRecord)) / sizeof(ResultsCpuRecord) ||
+        segment_count != (body - process_count * sizeof(ResultsProcessRecord) -
+                          (size_t)cpu_count * sizeof(ResultsCpuRecord)) / sizeof(ResultsSegmentRecord)) {
+        fprintf(stderr, "Error: %s is truncated or has a bad header\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    int n = (int)process_count;
+    Process *processes = (Process *)malloc((n ? n : 1) * sizeof(Process));
+    CPU *cpus = (CPU *)calloc(cpu_count, sizeof(CPU));
+    if (!processes || !cpus) {
+        perror("Failed to allocate replayed results");
+        exit(EXIT_FAILURE);
+    }
+    const ResultsProcessRecord *pr = (const ResultsProcessRecord *)(header + 1);
+    for (int i = 0; i < n; i++) {
+        Process *p = &processes[i];
+        init_process(p, (int32_t)le32((uint32_t)pr[i].pid), (int32_t)le32((uint32_t)pr[i].arrival_time),
+                     (int32_t)le32((uint32_t)pr[i].burst_time), (int32_t)le32((uint32_t)pr[i].priority));
+        p->start_time = (int32_t)le32((uint32_t)pr[i].start_time);
+        p->finish_time = (int32_t)le32((uint32_t)pr[i].finish_time);
+        p->waiting_time = (int32_t)le32((uint32_t)pr[i].waiting_time);
+        p->response_time = (int32_t)le32((uint32_t)pr[i].response_time);
+        if (p->finish_time != -1) p->state = COMPLETED;
+    }
+    const ResultsCpuRecord *cr = (const ResultsCpuRecord *)(pr + n);
+    for (int c = 0; c < cpu_count; c++) {
+        cpus[c].id = (int32_t)le32((uint32_t)cr[c].id);
+        cpus[c].busy_time = (int32_t)le32((uint32_t)cr[c].busy_time);
+        cpus[c].idle_time = (int32_t)le32((uint32_t)cr[c].idle_time);
+        cpus[c].overhead_time = (int32_t)le32((uint32_t)cr[c].overhead_time);
+        cpus[c].same_cpu_dispatches = (int32_t)le32((uint32_t)cr[c].same_cpu_dispatches);
+        cpus[c].migrated_dispatches = (int32_t)le32((uint32_t)cr[c].migrated_dispatches);
+        cpus[c].current_process = NULL;
+        cpus[c].idx = -1;
+    }
+
+    // Rebuild an RLE timeline only if it will be printed
+    Arena arena;
+    init_arena(&arena);
+    Timeline timeline;
+    bool has_timeline = le32((uint32_t)header->has_timeline) != 0 && (output & OUTPUT_TIMELINE);
+    init_timeline(&timeline, total_time > 0 ? total_time : 1, cpu_count,
+                  has_timeline ? TIMELINE_RLE : TIMELINE_NONE, &arena);
+    const ResultsSegmentRecord *sr = (const ResultsSegmentRecord *)(cr + cpu_count);
+    for (uint64_t k = 0; has_timeline && k < segment_count; k++) {
+        int cpu = (int32_t)le32((uint32_t)sr[k].cpu);
+        int start = (int32_t)le32((uint32_t)sr[k].start);
+        int end = (int32_t)le32((uint32_t)sr[k].end);
+        if (cpu < 0 || cpu >= cpu_count || start < 0 || end < start) continue;
+        if (end <= window->start || (window->end >= 0 && start >= window->end)) continue; // Not printed
+        timeline_record(&timeline, cpu, (int32_t)le32((uint32_t)sr[k].pid), start, end);
+    }
+
+    if (output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) {
+        printf("\nReplaying %s: %s on %d CPU(s)%s", filename, algorithm_name(algorithm), cpu_count,
+               algorithm_uses_quantum(algorithm) ? ", Quantum=" : "");
+        if (algorithm_uses_quantum(algorithm)) printf("%d", time_quantum);
+        printf("\n");
+    }
+    bool locality = le32((uint32_t)header->locality) != 0;
+    print_results(processes, n, cpus, cpu_count, &timeline, total_time, output, window, NULL, NULL, NULL, locality);
+
+    cleanup_timeline(&timeline);
+    free_arena(&arena);
+    free(processes);
+    free(cpus);
+    munmap(mapped, size);
+}
+
+/************************* PARALLEL EXECUTION *************************/
+
+/**
+ * Start `threads` - 1 helper threads that share the per-CPU part of each step
+ *
+ * The calling thread takes the first CPU block itself. CPUs are split into
+ * contiguous blocks, one per thread.
+ */
+void init_parallel(SimulationContext *ctx, int threads) {
+    if (threads > ctx->cpu_count) threads = ctx->cpu_count;
+    if (threads <= 1) return;
+
+    ParallelPool *pool = (ParallelPool *)malloc(sizeof(ParallelPool));
+    if (!pool) {
+        perror("Failed to allocate thread pool");
+        exit(EXIT_FAILURE);
+    }
+    pool->ctx = ctx;
+    pool->threads = threads;
+    pool->elapsed = 0;
+    pool->quit = false;
+    pool->finished = (bool *)calloc(ctx->cpu_count, sizeof(bool));
+    pool->tids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    pool->slices = (ParallelSlice *)malloc(threads * sizeof(ParallelSlice));
+    if (!pool->finished || !pool->tids || !pool->slices) {
+        perror("Failed to allocate thread pool");
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_init(&pool->start, NULL, threads);
+    pthread_barrier_init(&pool->done, NULL, threads);
+
+    for (int t = 0; t < threads; t++) {
+        pool->slices[t].pool = pool;
+        pool->slices[t].first_cpu = (int)((long)t * ctx->cpu_count / threads);
+        pool->slices[t].last_cpu = (int)((long)(t + 1) * ctx->cpu_count / threads);
+    }
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&pool->tids[t], NULL, parallel_worker, &pool->slices[t]) != 0) {
+            perror("Failed to start simulation thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    ctx->parallel = pool;
+}
+
+/**
+ * Stop and join the helper threads (no-op when running single-threaded)
+ */
+void cleanup_parallel(SimulationContext *ctx) {
+    ParallelPool *pool = ctx->parallel;
+    if (pool == NULL) return;
+
+    pool->quit = true;
+    pthread_barrier_wait(&pool->start);
+    for (int t = 1; t < pool->threads; t++) pthread_join(pool->tids[t], NULL);
+
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->done);
+    free(pool->finished);
+    free(pool->tids);
+    free(pool->slices);
+    free(pool);
+    ctx->parallel = NULL;
+}
+
+/**
+ * Record the timeline and execute one block of CPUs for the current step
+ */
+void execute_slice(ParallelSlice *slice) {
+    ParallelPool *pool = slice->pool;
+    SimulationContext *ctx = pool->ctx;
+    for (int c = slice->first_cpu; c < slice->last_cpu; c++) {
+        int pid = (ctx->cpus[c].current_process != NULL) ? ctx->cpus[c].current_process->pid : -1;
+        timeline_record(&ctx->timeline, c, pid, ctx->current_time, ctx->current_time + pool->elapsed);
+        pool->finished[c] = execute_cpu(ctx, c, pool->elapsed);
+    }
+}
+
+/**
+ * Helper thread body: wait for a step, run its CPU block, report back
+ */
+void *parallel_worker(void *arg) {
+    ParallelSlice *slice = (ParallelSlice *)arg;
+    ParallelPool *pool = slice->pool;
+    while (true) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->quit) break;
+        execute_slice(slice);
+        pthread_barrier_wait(&pool->done);
+    }
+    return NULL;
+}
+
+/**
+ * Timeline update and execution of one step across all threads
+ *
+ * Scheduling decisions stay on the calling thread; the barriers bracket the
+ * per-CPU work. Completions are then applied in CPU order, exactly as the
+ * serial loop would, so results do not depend on the thread count.
+ */
+void execute_parallel(SimulationContext *ctx, int elapsed) {
+    ParallelPool *pool = ctx->parallel;
+
+    // Any timeline growth happens here, before the threads touch it
+    timeline_reserve(&ctx->timeline, ctx->current_time + elapsed);
+
+    pool->elapsed = elapsed;
+    pthread_barrier_wait(&pool->start);
+    execute_slice(&pool->slices[0]);
+    pthread_barrier_wait(&pool->done);
+
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        if (pool->finished[c]) finish_on_cpu(ctx, c);
+    }
+}
+
+/************************* PER-CPU RUN QUEUES *************************/
+
+/**
+ * Give every CPU of `ctx` its own ready queue, filled by `placement`
+ */
+void init_runqueues(SimulationContext *ctx, QueuePlacement placement) {
+    RunQueues *rq = (RunQueues *)arena_alloc(ctx->arena, sizeof(RunQueues));
+    int n = ctx->cpu_count;
+    rq->queues = (ReadyQueue *)arena_alloc(ctx->arena, n * sizeof(ReadyQueue));
+    rq->steals = (unsigned long *)arena_calloc(ctx->arena, n, sizeof(unsigned long));
+    rq->length_time = (long long *)arena_calloc(ctx->arena, n, sizeof(long long));
+    rq->max_length = (int *)arena_calloc(ctx->arena, n, sizeof(int));
+    for (int c = 0; c < n; c++) {
+        init_queue(&rq->queues[c], 16, ctx->arena);
+        rq->queues[c].processes = ctx->processes;
+        rq->queues[c].stats = ctx->stats;
+    }
+    rq->count = n;
+    rq->placement = placement;
+    rq->next_cpu = 0;
+    ctx->runqueues = rq;
+}
+
+/**
+ * Release the per-CPU queues of a context (no-op in global mode)
+ */
+void cleanup_runqueues(SimulationContext *ctx) {
+    RunQueues *rq = ctx->runqueues;
+    if (rq == NULL) return;
+    for (int c = 0; c < rq->count; c++) free_queue(&rq->queues[c]);
+    ctx->runqueues = NULL;
+}
+
+/**
+ * The queue CPU `c` dispatches from and requeues its own jobs to
+ */
+ReadyQueue *cpu_queue(SimulationContext *ctx, int c) {
+    return ctx->runqueues ? &ctx->runqueues->queues[c] : &ctx->ready_queue;
+}
+
+/**
+ * The queue a newly arrived process goes to
+ *
+ * Least-loaded counts queued jobs plus the running one; ties go to the
+ * lowest CPU ID.
+ */
+ReadyQueue *arrival_queue(SimulationContext *ctx) {
+    RunQueues *rq = ctx->runqueues;
+    if (rq == NULL) return &ctx->ready_queue;
+
+    int target = 0;
+    if (rq->placement == PLACE_ROUND_ROBIN) {
+        target = rq->next_cpu;
+        rq->next_cpu = (rq->next_cpu + 1) % rq->count;
+    } else {
+        int best_load = INT_MAX;
+        for (int c = 0; c < rq->count; c++) {
+            int load = rq->queues[c].size + (ctx->cpus[c].current_process != NULL);
+            if (load < best_load) {
+                best_load = load;
+                target = c;
+            }
+        }
+    }
+    return &rq->queues[target];
+}
+
+/**
+ * Take the next job for CPU `c`, stealing the head of the longest peer
+ * queue when its own queue is empty. Returns -1 if every queue is empty.
+ */
+int runqueue_take(SimulationContext *ctx, int c) {
+    RunQueues *rq = ctx->runqueues;
+    int idx = dequeue(&rq->queues[c]);
+    if (idx != -1) return idx;
+
+    int victim = -1;
+    for (int v = 0; v < rq->count; v++) {
+        if (rq->queues[v].size > 0 && (victim == -1 || rq->queues[v].size > rq->queues[victim].size)) victim = v;
+    }
+    if (victim == -1) return -1;
+    rq->steals[c]++;
+    return dequeue(&rq->queues[victim]);
+}
+
+/**
+ * Accumulate per-CPU queue lengths over the next `elapsed` time units
+ */
+void sample_runqueues(SimulationContext *ctx, int elapsed) {
+    RunQueues *rq = ctx->runqueues;
+    for (int c = 0; c < rq->count; c++) {
+        int length = rq->queues[c].size;
+        rq->length_time[c] += (long long)length * elapsed;
+        if (length > rq->max_length[c]) rq->max_length[c] = length;
+    }
+}
+
+/**
+ * SRTF preemption against each CPU's own queue
+ *
+ * Same rule as the global version: the head of the CPU's queue replaces the
+ * running job unless the running job is shorter (then higher priority, then
+ * lower PID). The preempted job goes back to that CPU's queue.
+ */
+void handle_srtf_preemption_per_cpu(SimulationContext *ctx) {
+    Process *processes = ctx->processes;
+    CPU *cpus = ctx->cpus;
+    int current_time = ctx->current_time;
+
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        Process *cur = cpus[c].current_process;
+        if (cur == NULL) continue;
+        ReadyQueue *q = cpu_queue(ctx, c);
+        int idx = dequeue(q);
+        if (idx == -1) continue;
+
+        Process *p = &processes[idx];
+        if (cur->remaining_time < p->remaining_time ||
+            (cur->remaining_time == p->remaining_time && cur->priority > p->priority) ||
+            (cur->remaining_time == p->remaining_time && cur->priority == p->priority && cur->pid < p->pid)) {
+            enqueue(q, idx);
+            continue;
+        }
+        if (ctx->trace) trace_event(ctx->current_time, c, "preempt", cur);
+        cur->state = WAITING;
+        cur->ready_since = current_time;
+        enqueue(q, cpus[c].idx);
+
+        cpus[c].current_process = p;
+        cpus[c].idx = idx;
+        p->state = RUNNING;
+        dispatch_waited(p, current_time);
+        if (ctx->stats) ctx->stats->preemptions++;
+        stats_dispatch(ctx->stats, c, p);
+        charge_dispatch(ctx, c, p);
+        if (p->start_time == -1) {
+            p->start_time = current_time;
+            p->response_time = current_time - p->arrival_time;
+        }
+    }
+}
+
+/**
+ * Print steal counts and queue-length statistics of per-CPU run queues
+ */
+void print_runqueue_stats(const RunQueues *rq, int total_time) {
+    printf("\nRun Queue Statistics (%s placement):\n", placement_name(rq->placement));
+    printf("%-6s %-8s %-14s %-14s\n", "CPU ID", "Steals", "Avg Queue Len", "Max Queue Len");
+    printf("------------------------------------------\n");
+    for (int c = 0; c < rq->count; c++) {
+        double avg = total_time > 0 ? (double)rq->length_time[c] / total_time : 0.0;
+        printf("%-6d %-8lu %-14.2f %-14d\n", c, rq->steals[c], avg, rq->max_length[c]);
+    }
+    printf("------------------------------------------\n");
+}
+
+/**
+ * CSV form of print_runqueue_stats()
+ */
+void print_csv_runqueues(const RunQueues *rq, int total_time) {
+    printf("\nRun Queue Stats (CSV):\n");
+    printf("CPU_ID,Steals,AvgQueueLength,MaxQueueLength\n");
+    for (int c = 0; c < rq->count; c++) {
+        double avg = total_time > 0 ? (double)rq->length_time[c] / total_time : 0.0;
+        printf("%d,%lu,%.2f,%d\n", c, rq->steals[c], avg, rq->max_length[c]);
+    }
+}
+
+/************************* MULTILEVEL FEEDBACK QUEUE *************************/
+
+/**
+ * Give an MLFQ context its level queues (all empty)
+ */
+void init_mlfq(SimulationContext *ctx) {
+    MlfqQueues *m = (MlfqQueues *)arena_alloc(ctx->arena, sizeof(MlfqQueues));
+    for (int k = 0; k < MLFQ_LEVELS; k++) {
+        // level 0 takes every arrival, so it is sized like the global queue
+        init_queue(&m->levels[k], k == 0 ? ctx->process_count : 16, ctx->arena);
+        m->levels[k].processes = ctx->processes;
+    }
+    m->nonempty = 0;
+    ctx->mlfq = m;
+}
+
+/**
+ * Index of the lowest set bit of a non-zero mask
+ */
+int lowest_set_bit(unsigned mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Quantum of an MLFQ level: -q at the top, doubling on each level down
+ */
+int mlfq_quantum(int time_quantum, int level) {
+    return time_quantum << level;
+}
+
+/**
+ * Append a process to the back of one level
+ */
+void mlfq_enqueue(MlfqQueues *m, int process_idx, int level) {
+    enqueue(&m->levels[level], process_idx);
+    m->nonempty |= 1u << level;
+}
+
+/**
+ * Take the next process from the highest non-empty level (-1 if all empty)
+ */
+int mlfq_dequeue(MlfqQueues *m) {
+    if (m->nonempty == 0) return -1;
+    int level = lowest_set_bit(m->nonempty);
+    int idx = dequeue(&m->levels[level]);
+    if (m->levels[level].size == 0) m->nonempty &= ~(1u << level);
+    return idx;
+}
+
+/**
+ * Periodic priority boost: move every job back to level 0
+ *
+ * Queued jobs keep their relative order, upper levels first, behind whatever
+ * level 0 already holds.
+ */
+void mlfq_boost(SimulationContext *ctx) {
+    MlfqQueues *m = ctx->mlfq;
+    for (int k = 1; k < MLFQ_LEVELS; k++) {
+        int idx;
+        while ((idx = dequeue(&m->levels[k])) != -1) {
+            ctx->processes[idx].level = 0;
+            mlfq_enqueue(m, idx, 0);
+        }
+        m->nonempty &= ~(1u << k);
+    }
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        if (ctx->cpus[c].current_process != NULL) ctx->cpus[c].current_process->level = 0;
+    }
+}
+
+/**
+ * Let queued jobs take CPUs running jobs from a lower level
+ *
+ * Each round swaps the job on the lowest level (first such CPU on ties) for
+ * the next job of the highest queued level. The preempted job goes to the
+ * back of its own level and gets a fresh quantum when it next runs.
+ */
+void handle_mlfq_preemption(SimulationContext *ctx) {
+    MlfqQueues *m = ctx->mlfq;
+    while (m->nonempty != 0) {
+        int top = lowest_set_bit(m->nonempty);
+        int victim = -1;
+        for (int c = 0; c < ctx->cpu_count; c++) {
+            Process *p = ctx->cpus[c].current_process;
+            if (p == NULL || p->level <= top) continue;
+            if (victim < 0 || p->level > ctx->cpus[victim].current_process->level) victim = c;
+        }
+        if (victim < 0) return;
+
+        Process *cur = ctx->cpus[victim].current_process;
+        if (ctx->trace) trace_event(ctx->current_time, victim, "preempt", cur);
+        cur->state = READY;
+        cur->ready_since = ctx->current_time;
+        mlfq_enqueue(m, ctx->cpus[victim].idx, cur->level);
+        if (ctx->stats) ctx->stats->preemptions++;
+        dispatch_process(ctx, victim, mlfq_dequeue(m));
+    }
+}
+
+/************************* PRIORITY SCHEDULING *************************/
+
+/**
+ * Turn on aging for a PRIO/PPRIO context: every `period` time units in the
+ * ready queue raise a job's priority by one
+ *
+ * A dispatched job keeps the steps it earned, so the job it displaced cannot
+ * take the CPU straight back; they are dropped when it next joins the queue.
+ * Aging needs update-key, so the ready queue gets a position index, and a
+ * FIFO of waiting jobs ordered by when their next step is due. All jobs share
+ * the period, so a step pushed at the back is never due before the front.
+ */
+void init_aging(SimulationContext *ctx, int period) {
+    if (period <= 0 || (ctx->algorithm != PRIO && ctx->algorithm != PPRIO)) return;
+    ctx->aging_period = period;
+
+    int slots = ctx->process_capacity > 0 ? ctx->process_capacity : 1;
+    ctx->ready_queue.positions = (int *)arena_alloc(ctx->arena, slots * sizeof(int));
+    for (int i = 0; i < slots; i++) ctx->ready_queue.positions[i] = -1;
+    init_queue(&ctx->aging, slots, ctx->arena);
+}
+
+/**
+ * Queue a process by priority and, with aging on, schedule its first step
+ */
+void enqueue_by_priority(SimulationContext *ctx, int process_idx) {
+    Process *p = &ctx->processes[process_idx];
+    p->aged = 0;
+    enqueue(&ctx->ready_queue, process_idx);
+    if (ctx->aging_period == 0) return;
+
+    p->aging_due = ctx->current_time + ctx->aging_period;
+    enqueue(&ctx->aging, process_idx);
+    ctx->aging.entries[ctx->aging.rear].primary = p->aging_due;
+}
+
+/**
+ * Give every waiting job whose aging step is due now one more priority step
+ *
+ * Entries left behind by dispatched or requeued jobs no longer match the
+ * job's aging_due and are dropped.
+ */
+void handle_aging(SimulationContext *ctx) {
+    ReadyQueue *fifo = &ctx->aging;
+    while (fifo->size > 0 && fifo->entries[fifo->front].primary <= ctx->current_time) {
+        long long due = fifo->entries[fifo->front].primary;
+        int idx = dequeue(fifo);
+        Process *p = &ctx->processes[idx];
+        if (p->aging_due != due) continue;
+
+        p->aged++;
+        heap_update(&ctx->ready_queue, idx);
+        if (ctx->stats) ctx->stats->aging_steps++;
+
+        p->aging_due = ctx->current_time + ctx->aging_period;
+        enqueue(fifo, idx);
+        fifo->entries[fifo->rear].primary = p->aging_due;
+    }
+}
+
+/**
+ * PPRIO: let the best queued job take the CPU of a lower-priority one
+ *
+ * Each round swaps the running job with the lowest aged priority (first such
+ * CPU on ties) for the head of the queue, as long as the head's is strictly
+ * higher. Running jobs earn no further aging steps.
+ */
+void handle_priority_preemption(SimulationContext *ctx) {
+    ReadyQueue *q = &ctx->ready_queue;
+    while (q->size > 0) {
+        const Process *next = &ctx->processes[q->entries[0].process_idx];
+        int victim = -1;
+        for (int c = 0; c < ctx->cpu_count; c++) {
+            const Process *cur = ctx->cpus[c].current_process;
+            if (cur == NULL || cur->priority + cur->aged >= next->priority + next->aged) continue;
+            const Process *worst = victim < 0 ? NULL : ctx->cpus[victim].current_process;
+            if (worst == NULL || cur->priority + cur->aged < worst->priority + worst->aged) victim = c;
+        }
+        if (victim < 0) return;
+
+        Process *cur = ctx->cpus[victim].current_process;
+        if (ctx->trace) trace_event(ctx->current_time, victim, "preempt", cur);
+        cur->state = READY;
+        cur->ready_since = ctx->current_time;
+        enqueue_by_priority(ctx, ctx->cpus[victim].idx);
+        if (ctx->stats) ctx->stats->preemptions++;
+        dispatch_process(ctx, victim, dequeue(q));
+    }
+}
+
+/************************* INSTRUMENTATION *************************/
+
+/**
+ * Set up --stats counters for `cpu_count` CPUs
+ */
+void init_stats(SimStats *stats, int cpu_count) {
+    memset(stats, 0, sizeof(*stats));
+    stats->cpu_count = cpu_count;
+    stats->dispatches = (unsigned long *)calloc(cpu_count, sizeof(unsigned long));
+    stats->context_switches = (unsigned long *)calloc(cpu_count, sizeof(unsigned long));
+    stats->last_pid = (int *)malloc(cpu_count * sizeof(int));
+    if (!stats->dispatches || !stats->context_switches || !stats->last_pid) {
+        perror("Failed to allocate statistics");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < cpu_count; c++) stats->last_pid[c] = -1;
+}
+
+/**
+ * Point a context and every queue it already has at `stats`
+ */
+void attach_stats(SimulationContext *ctx, SimStats *stats) {
+    ctx->stats = stats;
+    ctx->ready_queue.stats = stats;
+    for (int k = 0; ctx->mlfq && k < MLFQ_LEVELS; k++) ctx->mlfq->levels[k].stats = stats;
+}
+
+/**
+ * Release --stats counters
+ */
+void free_stats(SimStats *stats) {
+    free(stats->dispatches);
+    free(stats->context_switches);
+    free(stats->last_pid);
+    stats->dispatches = NULL;
+    stats->context_switches = NULL;
+    stats->last_pid = NULL;
+}
+
+/**
+ * Monotonic clock in nanoseconds, for stage timings
+ */
+long long stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Charge the time since *mark to `stage` and restart the mark (no-op without stats)
+ */
+void stats_lap(SimStats *stats, SimStage stage, long long *mark) {
+    if (stats == NULL) return;
+    long long now = stats_now_ns();
+    stats->stage_ns[stage] += now - *mark;
+    *mark = now;
+}
+
+/**
+ * Count `p` being put on CPU `c`
+ *
+ * A context switch is a dispatch of a different process than the one the CPU
+ * ran last, so a job picked straight back up after its quantum is not one.
+ */
+void stats_dispatch(SimStats *stats, int c, const Process *p) {
+    if (stats == NULL) return;
+    stats->dispatches[c]++;
+    if (stats->last_pid[c] != p->pid) stats->context_switches[c]++;
+    stats->last_pid[c] = p->pid;
+}
+
+/************************* LATENCY PERCENTILES *************************/
+
+/**
+ * Histogram bucket of a non-negative value
+ *
+ * Values below HISTOGRAM_SUB_BUCKETS get their own bucket. Above that, each
+ * power of two is split into HISTOGRAM_SUB_BUCKETS / 2 equal buckets, so a
+ * bucket is never wider than 1/64 of the values it holds.
+ */
+int histogram_index(int value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) return value < 0 ? 0 : value;
+    int msb = 31 - __builtin_clz((unsigned)value);
+    int shift = msb - HISTOGRAM_SUB_BITS + 1;
+    return HISTOGRAM_SUB_BUCKETS + (shift - 1) * (HISTOGRAM_SUB_BUCKETS / 2) +
+           (value >> shift) - HISTOGRAM_SUB_BUCKETS / 2;
+}
+
+/**
+ * Largest value that falls into bucket `index`
+ */
+int histogram_bucket_top(int index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) return index;
+    int shift = (index - HISTOGRAM_SUB_BUCKETS) / (HISTOGRAM_SUB_BUCKETS / 2) + 1;
+    int sub = (index - HISTOGRAM_SUB_BUCKETS) % (HISTOGRAM_SUB_BUCKETS / 2) + HISTOGRAM_SUB_BUCKETS / 2;
+    return (int)((((long)sub + 1) << shift) - 1);
+}
+
+/**
+ * Count one value
+ */
+void histogram_add(Histogram *histogram, int value) {
+    histogram->counts[histogram_index(value)]++;
+    if (histogram->total == 0 || value > histogram->max) histogram->max = value;
+    histogram->total++;
+}
+
+/**
+ * Smallest recorded value with at least `per_ten_thousand` / 10000 of the values at or below it
+ *
+ * Exact below HISTOGRAM_SUB_BUCKETS; above, it is the top of the bucket (never more than max).
+ */
+int histogram_percentile(const Histogram *histogram, int per_ten_thousand) {
+    if (histogram->total == 0) return 0;
+    unsigned long rank = (unsigned long)((histogram->total * (unsigned long long)per_ten_thousand + 9999) / 10000);
+    if (rank == 0) rank = 1;
+    unsigned long seen = 0;
+    for (int k = 0; k < HISTOGRAM_BUCKETS; k++) {
+        seen += histogram->counts[k];
+        if (seen >= rank) {
+            int top = histogram_bucket_top(k);
+            return top < histogram->max ? top : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/**
+ * Set up empty --percentiles histograms
+ */
+void init_latency(LatencyMetrics *latency) {
+    memset(&latency->all, 0, sizeof(latency->all));
+    latency->classes = NULL;
+    latency->class_count = 0;
+    latency->dropped = 0;
+}
+
+/**
+ * Histograms of the priority class `priority`, created on first use; NULL past LATENCY_MAX_CLASSES
+ */
+LatencyClass *latency_class(LatencyMetrics *latency, int priority) {
+    // Classes are kept sorted by priority
+    int lo = 0, hi = latency->class_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (latency->classes[mid].priority < priority) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < latency->class_count && latency->classes[lo].priority == priority) return &latency->classes[lo];
+    if (latency->class_count == LATENCY_MAX_CLASSES) return NULL;
+
+    if (!latency->classes) {
+        latency->classes = (LatencyClass *)malloc(LATENCY_MAX_CLASSES * sizeof(LatencyClass));
+        if (!latency->classes) {
+            perror("Failed to allocate latency histograms");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memmove(&latency->classes[lo + 1], &latency->classes[lo],
+            (latency->class_count - lo) * sizeof(LatencyClass));
+    memset(&latency->classes[lo], 0, sizeof(LatencyClass));
+    latency->classes[lo].priority = priority;
+    latency->class_count++;
+    return &latency->classes[lo];
+}
+
+/**
+ * Count a process that just completed, overall and in its priority class
+ */
+void record_latency(LatencyMetrics *latency, const Process *p) {
+    int turnaround = p->finish_time - p->arrival_time;
+    histogram_add(&latency->all.turnaround, turnaround);
+    histogram_add(&latency->all.waiting, p->waiting_time);
+    histogram_add(&latency->all.response, p->response_time);
+
+    LatencyClass *cls = latency_class(latency, p->priority);
+    if (!cls) {
+        latency->dropped++;
+        return;
+    }
+    histogram_add(&cls->turnaround, turnaround);
+    histogram_add(&cls->waiting, p->waiting_time);
+    histogram_add(&cls->response, p->response_time);
+}
+
+/**
+ * Release --percentiles histograms
+ */
+void free_latency(LatencyMetrics *latency) {
+    free(latency->classes);
+    latency->classes = NULL;
+    latency->class_count = 0;
+}
+
+/**
+ * Print the percentile table in human-readable form
+ */
+void print_latency(const LatencyMetrics *latency) {
+    if (latency->all.turnaround.total == 0) {
+        printf("\nNo processes completed. Cannot calculate latency percentiles.\n");
+        return;
+    }
+    printf("\nLatency Percentiles (for %lu completed processes):\n", latency->all.turnaround.total);
+    printf("  %-13s %-10s %8s %8s %8s %8s %8s %8s\n", "Class", "Metric", "Count", "P50", "P90", "P99", "P99.9", "Max");
+    for (int k = -1; k < latency->class_count; k++) {
+        const LatencyClass *cls = k < 0 ? &latency->all : &latency->classes[k];
+        char name[32];
+        if (k < 0) snprintf(name, sizeof(name), "all");
+        else snprintf(name, sizeof(name), "priority %d", cls->priority);
+        const Histogram *metrics[3] = {&cls->turnaround, &cls->waiting, &cls->response};
+        for (int m = 0; m < 3; m++) {
+            const Histogram *h = metrics[m];
+            printf("  %-13s %-10s %8lu %8d %8d %8d %8d %8d\n", m == 0 ? name : "", LATENCY_METRIC_NAMES[m], h->total,
+                   histogram_percentile(h, 5000), histogram_percentile(h, 9000), histogram_percentile(h, 9900),
+                   histogram_percentile(h, 9990), h->max);
+        }
+    }
+    if (latency->dropped > 0) {
+        printf("  (%lu processes with priorities beyond the first %d classes are counted under \"all\" only)\n",
+               latency->dropped, LATENCY_MAX_CLASSES);
+    }
+}
+
+/**
+ * Print the percentile table as a CSV block
+ */
+void print_csv_latency(const LatencyMetrics *latency) {
+    printf("\nLatency Percentiles (CSV):\n");
+    printf("Class,Metric,Count,P50,P90,P99,P99.9,Max\n");
+    for (int k = -1; k < latency->class_count; k++) {
+        const LatencyClass *cls = k < 0 ? &latency->all : &latency->classes[k];
+        const Histogram *metrics[3] = {&cls->turnaround, &cls->waiting, &cls->response};
+        for (int m = 0; m < 3; m++) {
+            const Histogram *h = metrics[m];
+            if (k < 0) printf("all,");
+            else printf("%d,", cls->priority);
+            if (h->total == 0) {
+                printf("%s,0,N/A,N/A,N/A,N/A,N/A\n", LATENCY_METRIC_NAMES[m]);
+                continue;
+            }
+            printf("%s,%lu,%d,%d,%d,%d,%d\n", LATENCY_METRIC_NAMES[m], h->total,
+                   histogram_percentile(h, 5000), histogram_percentile(h, 9000), histogram_percentile(h, 9900),
+                   histogram_percentile(h, 9990), h->max);
+        }
+    }
+}
+
+/************************* SIMULATION COMPONENTS *************************/
+
+/**
+ * Handle process arrivals at the current time
+ *
+ * `ctx->arrival_order` is the index from build_arrival_order() and
+ * `ctx->arrival_cursor` points at the first process that has not arrived yet,
+ * so only the processes arriving now are touched.
+ */
+void handle_arrivals(SimulationContext *ctx) {
+    if (ctx == NULL || ctx->processes == NULL || ctx->arrived_indices == NULL ||
+        (ctx->stream == NULL && ctx->arrival_order == NULL)){
+        perror("There was a variable that was NULL in the handle_arrivals function");
+        return;
+    }
+    ctx->arrival_count = 0;
+
+    if (ctx->stream != NULL) {
+        // admit every streamed record whose arrival time is now
+        int fields[4];
+        while (stream_peek(ctx->stream, fields) && fields[1] == ctx->current_time) {
+            ctx->stream->has_pending = false;
+            int i = alloc_process_slot(ctx);
+            init_process(&ctx->processes[i], fields[0], fields[1], fields[2], fields[3]);
+
+            if (ctx->arrival_count >= ctx->arrived_capacity) {
+                ctx->arrived_indices = (int *)arena_grow(ctx->arena, ctx->arrived_indices,
+                                                         ctx->arrived_capacity * sizeof(int),
+                                                         2 * ctx->arrived_capacity * sizeof(int));
+                ctx->arrived_capacity *= 2;
+            }
+            ctx->processes[i].state = READY;
+            ctx->processes[i].ready_since = ctx->current_time;
+            ctx->arrived_indices[ctx->arrival_count++] = i;
+        }
+    }
+
+    Process *processes = ctx->processes;
+    const int *arrival_order = ctx->arrival_order;
+    int *arrived_indices = ctx->arrived_indices;
+
+    // arrival times already behind the clock (e.g. negative) never match, same as a full scan
+    while (ctx->stream == NULL && ctx->arrival_cursor < ctx->process_count &&
+           processes[arrival_order[ctx->arrival_cursor]].arrival_time < ctx->current_time){
+        ctx->arrival_cursor++;
+    }
+
+    // take every process whose arrival time matches the current time
+    while (ctx->stream == NULL && ctx->arrival_cursor < ctx->process_count &&
+           processes[arrival_order[ctx->arrival_cursor]].arrival_time == ctx->current_time){
+        int i = arrival_order[ctx->arrival_cursor];
+        ctx->arrival_cursor++;
+
+        // arrived_indices has room for every process, so nothing can be dropped here
+        processes[i].state = READY;         
+        processes[i].ready_since = ctx->current_time;
+        arrived_indices[ctx->arrival_count] = i;
+        processes[i].quantum_used = 0;          // for RR
+        ctx->arrival_count++; 
+    }
+    
+    // Queue the arrivals the way the algorithm orders its ready queue
+    void (*admit)(SimulationContext *, int) = ctx->policy.admit;
+    for (int idx = 0; idx < ctx->arrival_count; idx++) {
+        if (ctx->trace) trace_event(ctx->current_time, -1, "arrive", &processes[arrived_indices[idx]]);
+        admit(ctx, arrived_indices[idx]);
+    }
+}
+
+/**
+ * Handle quantum expiration for Round Robin scheduling
+ *
+ * Under MLFQ the quantum depends on the job's level, and an expired job is
+ * demoted one level (down to the last) before it is requeued.
+ */
+void handle_rr_quantum_expiry(SimulationContext *ctx) {
+    CPU *cpus = ctx->cpus;
+
+    // loop through the CPU list and check to see if it has been running for too
+    for (int i = 0; i < ctx->cpu_count; i++){
+
+        if (cpus[i].current_process == NULL){
+            continue;
+        }
+
+        // if there is still time left and if it is still running
+        if (cpus[i].current_process->remaining_time > 0 && cpus[i].current_process->state == RUNNING){
+
+            // get the current process
+            Process *curr = cpus[i].current_process;
+            
+            // if the quantum used is greater than the max quantum time, put it to the back of the list
+            if (curr->quantum_used >= ctx->policy.quantum(ctx, curr)){
+
+                // resetting time quantum
+                if (ctx->trace) trace_event(ctx->current_time, i, "expire", curr);
+                curr->quantum_used = 0;
+                if (ctx->stats) ctx->stats->quantum_expiries++;
+                curr->state = READY;
+                curr->ready_since = ctx->current_time;
+                ctx->policy.requeue(ctx, i, curr - ctx->processes);
+                cpus[i].current_process = NULL;
+            }
+        }
+    }
+}
+
+/**
+ * Implement preemptive scheduling for SRTF
+ */
+void handle_srtf_preemption(SimulationContext *ctx) {
+    Process *processes = ctx->processes;
+    CPU *cpus = ctx->cpus;
+    int current_time = ctx->current_time;
+
+    int idx = dequeue(&ctx->ready_queue);
+    if (idx == -1) return;
+
+    Process *p = &processes[idx];
+
+    for (int c = 0; c < ctx->cpu_count ; c++){
+        int next_remaining = p -> remaining_time;
+        int next_priority = p -> priority;
+        Process *cur = cpus[c].current_process;
+        if (cur == NULL) continue;
+        int cur_remaining = cur -> remaining_time;
+        int cur_priority = cur -> priority;
+
+        if (cur_remaining < next_remaining || 
+            (cur_remaining == next_remaining && cur_priority > next_priority) ||
+        (cur_remaining == next_remaining && cur_priority == next_priority && cur -> pid < p -> pid)) continue;
+        if (ctx->trace) trace_event(ctx->current_time, c, "preempt", cur);
+        cpus[c].current_process = p;
+        p -> state = RUNNING;
+        dispatch_waited(p, current_time);
+        if (ctx->stats) ctx->stats->preemptions++;
+        stats_dispatch(ctx->stats, c, p);
+        charge_dispatch(ctx, c, p);
+        if (p->start_time == -1) {
+            p->start_time = current_time;
+            p->response_time = current_time - p->arrival_time;
+        }
+        cur -> state = WAITING;
+        cur -> ready_since = current_time;
+        enqueue(&ctx->ready_queue, cpus[c].idx);
+        cpus[c].idx = idx;
+        idx = dequeue(&ctx->ready_queue); //this will never return -1
+        p = &processes[idx];
+    }
+    enqueue(&ctx->ready_queue, idx);
+}
+
+/**
+ * Assign processes to idle CPUs based on the current scheduling algorithm
+ */
+void assign_processes_to_idle_cpus(SimulationContext *ctx) {
+    Process *processes = ctx->processes;
+    CPU *cpus = ctx->cpus;
+    int current_time = ctx->current_time;
+    int (*take)(SimulationContext *, int) = ctx->policy.take;
+
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        if (ctx->stats) ctx->stats->idle_scans++;
+        if (cpus[c].current_process != NULL) continue; //if null, don't skip
+
+        int idx = take(ctx, c);
+        if (idx == -1) break;
+
+        Process *p = &processes[idx];
+
+        if (p->state == COMPLETED || p->arrival_time > current_time) {
+            c--;
+            continue;
+        }
+
+        dispatch_process(ctx, c, idx);
+    }
+
+}
+
+/**
+ * Turn on affinity-preferring dispatch (--affinity) with a wait threshold
+ */
+void init_affinity(SimulationContext *ctx, int wait) {
+    if (wait < 0) return;
+    ctx->affinity_wait = wait;
+    ctx->affinity_window = (QueueEntry *)arena_alloc(ctx->arena,
+                                                     (ctx->cpu_count + AFFINITY_LOOKAHEAD) * sizeof(QueueEntry));
+}
+
+/**
+ * Fill idle CPUs from the global queue, preferring each job's last CPU
+ *
+ * The first jobs in service order (one per idle CPU plus AFFINITY_LOOKAHEAD)
+ * are taken off the queue. A job whose last CPU is idle goes back to it.
+ * Remaining idle CPUs, in index order, take the first job that never ran,
+ * or whose last CPU is busy and that has waited affinity_wait time units;
+ * with 0 no job ever waits for its CPU. Everything else goes back in its
+ * original order, and the earliest time a held job may move becomes an event.
+ */
+void assign_with_affinity(SimulationContext *ctx) {
+    ReadyQueue *q = &ctx->ready_queue;
+    Process *processes = ctx->processes;
+    CPU *cpus = ctx->cpus;
+    int current_time = ctx->current_time;
+    QueueEntry *window = ctx->affinity_window;
+    ctx->affinity_deadline = INT_MAX;
+
+    int idle = 0;
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        if (ctx->stats) ctx->stats->idle_scans++;
+        if (cpus[c].current_process == NULL) idle++;
+    }
+    if (idle == 0) return;
+
+    int taken = 0;
+    while (taken < idle + AFFINITY_LOOKAHEAD && queue_pop_entry(q, &window[taken])) {
+        const Process *p = &processes[window[taken].process_idx];
+        if (p->state == COMPLETED || p->arrival_time > current_time) {
+            if (ctx->stats) ctx->stats->dequeues++; // Stale entry, dropped as dequeue() callers do
+            continue;
+        }
+        taken++;
+    }
+
+    // Jobs whose last CPU is free go back to it
+    for (int k = 0; k < taken && idle > 0; k++) {
+        int c = processes[window[k].process_idx].last_cpu;
+        if (c < 0 || cpus[c].current_process != NULL) continue;
+        dispatch_process(ctx, c, window[k].process_idx);
+        if (ctx->stats) ctx->stats->dequeues++;
+        window[k].process_idx = -1;
+        idle--;
+    }
+
+    // Other idle CPUs take the first job that is free to move
+    int k = 0;
+    for (int c = 0; c < ctx->cpu_count && idle > 0; c++) {
+        if (cpus[c].current_process != NULL) continue;
+        while (k < taken) {
+            int idx = window[k].process_idx;
+            if (idx != -1 && (processes[idx].last_cpu < 0 ||
+                              current_time - processes[idx].ready_since >= ctx->affinity_wait)) break;
+            k++;
+        }
+        if (k == taken) break;
+        dispatch_process(ctx, c, window[k].process_idx);
+        if (ctx->stats) ctx->stats->dequeues++;
+        window[k].process_idx = -1;
+        idle--;
+    }
+
+    for (int j = taken - 1; j >= 0; j--) {
+        int idx = window[j].process_idx;
+        if (idx == -1) continue;
+        if (processes[idx].last_cpu >= 0) {
+            int due = processes[idx].ready_since + ctx->affinity_wait;
+            if (due > current_time && due < ctx->affinity_deadline) ctx->affinity_deadline = due;
+        }
+        queue_restore_entry(q, &window[j]);
+    }
+}
+
+/**
+ * Put process `idx` on idle CPU `c` with a fresh quantum
+ */
+void dispatch_process(SimulationContext *ctx, int c, int idx) {
+    Process *p = &ctx->processes[idx];
+    int current_time = ctx->current_time;
+
+    ctx->cpus[c].current_process = p;
+    ctx->cpus[c].idx = idx;
+    p->state = RUNNING;
+    p->aging_due = -1; // no more aging steps while it runs
+    dispatch_waited(p, current_time);
+    stats_dispatch(ctx->stats, c, p);
+    charge_dispatch(ctx, c, p);
+
+    if (p->start_time == -1) {
+        p->start_time = current_time;
+        p->response_time = current_time - p->arrival_time;
+    }
+
+    p->quantum_used = 0;
+}
+
+/**
+ * Start CPU `c` on the switch and migration overhead of dispatching `p`
+ *
+ * Like --stats, a context switch is a dispatch of a different process than
+ * the CPU ran last. A migration is a dispatch on another CPU than the one
+ * the process last ran on. Every dispatch sets the overhead anew, so time a
+ * preempted process had not yet paid is simply lost.
+ */
+void charge_dispatch(SimulationContext *ctx, int c, Process *p) {
+    CPU *cpu = &ctx->cpus[c];
+    int overhead = 0;
+    if (cpu->last_pid != p->pid) overhead += ctx->switch_cost;
+    if (p->last_cpu != -1 && p->last_cpu != c) {
+        overhead += ctx->migration_cost;
+        cpu->migrated_dispatches++;
+    } else if (p->last_cpu == c) {
+        cpu->same_cpu_dispatches++;
+    }
+    cpu->overhead_left = overhead;
+    cpu->last_pid = p->pid;
+    p->last_cpu = c;
+    if (ctx->trace) trace_event(ctx->current_time, c, "dispatch", p);
+}
+
+/**
+ * Set the overhead model (--switch-cost, --migration-cost); both default to free
+ */
+void init_overhead(SimulationContext *ctx, int switch_cost, int migration_cost) {
+    ctx->switch_cost = switch_cost;
+    ctx->migration_cost = migration_cost;
+}
+
+/**
+ * Set the time at which a run gives up (--max-time), or derive one from the workload
+ *
+ * Every policy keeps a CPU busy while a job is ready, so a loaded workload
+ * finishes by its last arrival plus its total burst (counting a zero burst
+ * as one unit). Dispatch overhead can add up to the switch and migration cost
+ * per dispatch, and there are at most about one dispatch per unit of burst
+ * plus one per job, so the default allows for that. A stream has no known
+ * end and gets no default limit. Call after init_overhead().
+ */
+void init_horizon(SimulationContext *ctx, int max_time) {
+    if (max_time > 0 || ctx->stream != NULL) {
+        ctx->max_time = max_time > 0 ? max_time : INT_MAX;
+        return;
+    }
+
+    long long last_arrival = 0;
+    long long work = 0;
+    for (int i = 0; i < ctx->process_count; i++) {
+        const Process *p = &ctx->processes[i];
+        if (p->arrival_time > last_arrival) last_arrival = p->arrival_time;
+        work += p->burst_time > 0 ? p->burst_time : 1;
+    }
+    long long per_unit = 1 + (long long)ctx->switch_cost + ctx->migration_cost;
+    long long horizon = last_arrival + (work + ctx->process_count) * per_unit + 1;
+    ctx->max_time = horizon < INT_MAX ? (int)horizon : INT_MAX;
+}
+
+/**
+ * Print one --trace line: time, CPU ("-" for arrivals), event and process
+ *
+ * A completion is stamped with the finish time, the end of the step it ran in.
+ */
+void trace_event(int time, int c, const char *event, const Process *p) {
+    if (c < 0) {
+        fprintf(stderr, "[trace] t=%d cpu=- %s pid=%d remaining=%d\n", time, event, p->pid,
+                p->remaining_time);
+    } else {
+        fprintf(stderr, "[trace] t=%d cpu=%d %s pid=%d remaining=%d\n", time, c, event, p->pid,
+                p->remaining_time);
+    }
+}
+
+/**
+ * Charge a process for the time it sat in the ready queue, as it is dispatched
+ */
+void dispatch_waited(Process *p, int current_time) {
+    if (p->ready_since >= 0) p->waiting_time += current_time - p->ready_since;
+    p->ready_since = -1;
+}
+
+/**
+ * Execute processes on CPUs for the next `elapsed` time units
+ *
+ * The caller guarantees no scheduling event falls inside the interval, so a
+ * running process either keeps its CPU for the whole interval or finishes
+ * exactly at its end.
+ */
+void execute_processes(SimulationContext *ctx, int elapsed) {
+    for (int c = 0 ; c < ctx->cpu_count ; c++){ 
+        if (execute_cpu(ctx, c, elapsed)) finish_on_cpu(ctx, c);
+    }
+}
+
+/**
+ * Run CPU `c` for `elapsed` time units; true if its process just finished
+ *
+ * Touches only CPU `c` and its process, so CPUs can run on separate threads.
+ * The shared completion bookkeeping is left to finish_on_cpu().
+ */
+bool execute_cpu(SimulationContext *ctx, int c, int elapsed) {
+    CPU *cpu = &ctx->cpus[c];
+    // check each CPU. If something is mounted, do work (increase busy time, decrease remaining time)
+    //if nothing is running increase idle time. Throw away tasks that finished.
+    if (cpu->current_process != NULL) {
+        Process *p = cpu->current_process;
+        int progress = elapsed;
+
+        // Switch and migration overhead: busy, but the process makes no progress
+        if (cpu->overhead_left > 0) {
+            int spent = cpu->overhead_left < elapsed ? cpu->overhead_left : elapsed;
+            cpu->overhead_left -= spent;
+            cpu->overhead_time += spent;
+            cpu->busy_time += spent;
+            progress -= spent;
+            if (progress == 0) return false;
+        }
+
+        p->remaining_time -= progress;
+        cpu->busy_time += progress;
+        p->quantum_used += progress;
+
+        if (p->remaining_time <= 0) {
+            p->finish_time = ctx->current_time + elapsed; // time is advanced after execution
+            p->state = COMPLETED;
+            cpu->current_process = NULL;
+            return true;
+        }
+    } else {
+        cpu->idle_time += elapsed;
+    }
+    return false;
+}
+
+/**
+ * Count the process that just finished on CPU `c`
+ */
+void finish_on_cpu(SimulationContext *ctx, int c) {
+    ctx->completed_count++;
+    if (ctx->trace) {
+        const Process *p = &ctx->processes[ctx->cpus[c].idx];
+        trace_event(p->finish_time, c, "finish", p);
+    }
+    if (ctx->latency) record_latency(ctx->latency, &ctx->processes[ctx->cpus[c].idx]);
+    if (ctx->stream != NULL) retire_stream_process(ctx, ctx->cpus[c].idx);
+}
+
+/**
+ * Compute how many time units can pass before the next scheduling event
+ *
+ * Events are the next arrival, the next completion, (for RR and MLFQ) the
+ * next quantum expiry, (for MLFQ) the next priority boost and (with --aging)
+ * the next aging step. SRTF preemption only becomes possible when the ready queue
+ * or the set of running processes changes, i.e. at one of those events, since
+ * running jobs only get shorter in between. Returns at least 1.
+ */
+int next_event_delta(SimulationContext *ctx) {
+    int delta = INT_MAX;
+
+    // handle_arrivals() leaves the cursor (or stream) on the first future arrival
+    int fields[4];
+    if (ctx->stream != NULL) {
+        if (stream_peek(ctx->stream, fields) && fields[1] > ctx->current_time) delta = fields[1] - ctx->current_time;
+    } else if (ctx->arrival_cursor < ctx->process_count) {
+        int next_arrival = ctx->processes[ctx->arrival_order[ctx->arrival_cursor]].arrival_time;
+        if (next_arrival > ctx->current_time) delta = next_arrival - ctx->current_time;
+    }
+
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        Process *p = ctx->cpus[c].current_process;
+        if (p == NULL) continue;
+
+        // Pending overhead postpones both the completion and the quantum expiry
+        int overhead = ctx->cpus[c].overhead_left;
+        int until_done = overhead + (p->remaining_time > 0 ? p->remaining_time : 1);
+        if (until_done < delta) delta = until_done;
+
+        if (ctx->policy.quantum) {
+            int until_expiry = ctx->policy.quantum(ctx, p) - p->quantum_used;
+            if (until_expiry < 1) until_expiry = 1;
+            until_expiry += overhead;
+            if (until_expiry < delta) delta = until_expiry;
+        }
+    }
+
+    if (ctx->aging.size > 0) {
+        long long until_aging = ctx->aging.entries[ctx->aging.front].primary - ctx->current_time;
+        if (until_aging > 0 && until_aging < delta) delta = (int)until_aging;
+    }
+
+    // A job held for its busy last CPU may move to another one
+    if (ctx->affinity_deadline != INT_MAX && ctx->affinity_deadline > ctx->current_time &&
+        ctx->affinity_deadline - ctx->current_time < delta) {
+        delta = ctx->affinity_deadline - ctx->current_time;
+    }
+
+    int boost_period = ctx->policy.boost_period;
+    if (boost_period > 0) {
+        int until_boost = boost_period - ctx->current_time % boost_period;
+        if (until_boost < delta) delta = until_boost;
+    }
+
+    // Nothing left that could change the schedule; fall back to single ticks
+    if (delta == INT_MAX) delta = 1;
+    return delta;
+}
+
+/************************* MAIN SIMULATION *************************/
+
+/**
+ * Set up a simulation context for one run over `processes`
+ *
+ * All scheduler state lives in the context, so independent contexts (each
+ * over its own copy of the process array) can run side by side.
+ */
+void init_simulation(SimulationContext *ctx, Process *processes, int process_count, int cpu_count,
+                     Algorithm algorithm, int time_quantum, SimMode mode, TimelineStorage storage,
+                     Arena *arena) {
+    ctx->processes = processes;
+    ctx->process_count = process_count;
+    ctx->cpu_count = cpu_count;
+    ctx->algorithm = algorithm;
+    ctx->time_quantum = time_quantum;
+    ctx->mode = mode;
+
+    // One block up front for everything the run is expected to need; a reused
+    // arena is already sized by the run before
+    ctx->arena = arena;
+    if (arena->head == NULL) {
+        arena_reserve(arena, estimate_arena_size(processes, process_count, cpu_count, storage));
+    }
+
+    // Size the ready queue for the whole workload; it still grows if needed
+    init_queue(&ctx->ready_queue, process_count, arena);
+
+    ctx->cpus = (CPU *)arena_calloc(arena, cpu_count, sizeof(CPU));
+    for (int i = 0; i < cpu_count; i++) {
+        ctx->cpus[i].id = i;
+        ctx->cpus[i].last_pid = -1;
+    }
+
+    init_timeline(&ctx->timeline, INITIAL_TIMELINE_CAPACITY, cpu_count, storage, arena);
+
+    ctx->arrival_order = build_arrival_order(processes, process_count, arena);
+    ctx->arrival_cursor = 0;
+
+    // At most every process can arrive in the same time unit
+    ctx->arrived_capacity = process_count > 0 ? process_count : 1;
+    ctx->arrived_indices = (int *)arena_alloc(arena, ctx->arrived_capacity * sizeof(int));
+    ctx->arrival_count = 0;
+
+    ctx->stream = NULL;
+    ctx->process_capacity = process_count;
+    ctx->free_slots.values = NULL;
+    ctx->free_slots.count = 0;
+    ctx->free_slots.capacity = 0;
+    ctx->stream_output = 0;
+    ctx->stream_turnaround = 0.0;
+    ctx->stream_waiting = 0.0;
+    ctx->stream_response = 0.0;
+
+    ctx->current_time = 0;
+    ctx->completed_count = 0;
+    ctx->total_time = 0;
+    ctx->trace = false;
+    ctx->max_time = INT_MAX;
+    ctx->stopped_early = false;
+    ctx->quiet = false;
+    ctx->stats = NULL;
+    ctx->latency = NULL;
+    ctx->switch_cost = 0;
+    ctx->migration_cost = 0;
+    ctx->affinity_wait = -1;
+    ctx->affinity_deadline = INT_MAX;
+    ctx->affinity_window = NULL;
+    ctx->runqueues = NULL;
+    ctx->parallel = NULL;
+    ctx->mlfq = NULL;
+    if (algorithm == MLFQ) init_mlfq(ctx);
+    ctx->aging_period = 0;
+    ctx->aging.entries = NULL;
+    ctx->aging.size = 0;
+    ctx->checkpoints = NULL;
+}
+
+/**
+ * Whether any process is still to arrive or to finish
+ */
+bool simulation_pending(SimulationContext *ctx) {
+    int fields[4];
+    if (ctx->stream == NULL) return ctx->completed_count < ctx->process_count;
+
+    // completed stream slots are freed at once, so every occupied slot is still live
+    return ctx->process_count > ctx->free_slots.count || stream_peek(ctx->stream, fields);
+}
+
+/**
+ * Fill in the loop steps of the context's algorithm
+ *
+ * Called after every init_* option is applied, since the steps depend on
+ * aging and the run queue layout as well as on the algorithm.
+ */
+void select_policy(SimulationContext *ctx) {
+    Policy *policy = &ctx->policy;
+    policy->tick = NULL;
+    policy->assign = ctx->affinity_window ? assign_with_affinity : assign_processes_to_idle_cpus;
+    policy->preempt = NULL;
+    policy->take = ctx->runqueues ? runqueue_take : take_global;
+    policy->requeue = ctx->runqueues ? requeue_own : requeue_global;
+    policy->quantum = NULL;
+    policy->boost_period = 0;
+
+    switch (ctx->algorithm) {
+        case FCFS:
+            policy->admit = admit_fcfs;
+            order_queues(ctx, ORDER_ARRIVAL);
+            break;
+        case RR:
+            policy->admit = admit_rr;
+            policy->tick = handle_rr_quantum_expiry;
+            policy->quantum = quantum_fixed;
+            break;
+        case SRTF:
+            policy->admit = admit_shortest;
+            policy->preempt = ctx->runqueues ? handle_srtf_preemption_per_cpu : handle_srtf_preemption;
+            order_queues(ctx, ORDER_REMAINING);
+            break;
+        case SJF:
+            policy->admit = admit_shortest;
+            order_queues(ctx, ORDER_REMAINING);
+            break;
+        case MLFQ:
+            policy->admit = admit_mlfq;
+            policy->tick = mlfq_tick;
+            policy->preempt = handle_mlfq_preemption;
+            policy->take = take_mlfq;
+            policy->requeue = requeue_demoted;
+            policy->quantum = quantum_mlfq;
+            policy->boost_period = MLFQ_BOOST_PERIOD;
+            break;
+        case PRIO:
+        case PPRIO:
+            policy->admit = admit_priority;
+            if (ctx->aging_period > 0) policy->tick = handle_aging;
+            if (ctx->algorithm == PPRIO) policy->preempt = handle_priority_preemption;
+            order_queues(ctx, ORDER_PRIORITY);
+            break;
+        default:
+            fprintf(stderr, "Error: wrong algorithm type %d\n", (int)ctx->algorithm);
+            exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Give the global ready queue and any per-CPU queues the heap order of the algorithm
+ */
+void order_queues(SimulationContext *ctx, QueueOrder order) {
+    queue_set_order(&ctx->ready_queue, order, ctx->processes);
+    if (ctx->runqueues == NULL) return;
+    for (int c = 0; c < ctx->runqueues->count; c++) {
+        queue_set_order(&ctx->runqueues->queues[c], order, ctx->processes);
+    }
+}
+
+/**
+ * Every CPU dispatches from the global ready queue
+ */
+int take_global(SimulationContext *ctx, int c) {
+    (void)c;
+    return dequeue(&ctx->ready_queue);
+}
+
+/**
+ * MLFQ: the front of the highest non-empty level
+ */
+int take_mlfq(SimulationContext *ctx, int c) {
+    (void)c;
+    return mlfq_dequeue(ctx->mlfq);
+}
+
+/**
+ * RR expiry: back of the global queue
+ */
+void requeue_global(SimulationContext *ctx, int c, int idx) {
+    (void)c;
+    enqueue(&ctx->ready_queue, idx);
+}
+
+/**
+ * RR expiry with --runqueues: back of the CPU's own queue
+ */
+void requeue_own(SimulationContext *ctx, int c, int idx) {
+    enqueue(&ctx->runqueues->queues[c], idx);
+}
+
+/**
+ * MLFQ expiry: one level down (the bottom level keeps it), at the back
+ */
+void requeue_demoted(SimulationContext *ctx, int c, int idx) {
+    (void)c;
+    Process *p = &ctx->processes[idx];
+    if (p->level < MLFQ_LEVELS - 1) p->level++;
+    mlfq_enqueue(ctx->mlfq, idx, p->level);
+}
+
+/**
+ * RR: the same -q for every job
+ */
+int quantum_fixed(const SimulationContext *ctx, const Process *p) {
+    (void)p;
+    return ctx->time_quantum;
+}
+
+/**
+ * MLFQ: the quantum of the job's current level
+ */
+int quantum_mlfq(const SimulationContext *ctx, const Process *p) {
+    return mlfq_quantum(ctx->time_quantum, p->level);
+}
+
+/**
+ * FCFS arrival: order by arrival time
+ */
+void admit_fcfs(SimulationContext *ctx, int idx) {
+    enqueue(arrival_queue(ctx), idx);
+}
+
+/**
+ * RR arrival: join the back of the FIFO
+ */
+void admit_rr(SimulationContext *ctx, int idx) {
+    enqueue(arrival_queue(ctx), idx);
+}
+
+/**
+ * SRTF/SJF arrival: order by remaining time
+ */
+void admit_shortest(SimulationContext *ctx, int idx) {
+    enqueue(arrival_queue(ctx), idx);
+}
+
+/**
+ * PRIO/PPRIO arrival: order by effective priority
+ */
+void admit_priority(SimulationContext *ctx, int idx) {
+    enqueue_by_priority(ctx, idx);
+}
+
+/**
+ * MLFQ arrival: new jobs start on the top level
+ */
+void admit_mlfq(SimulationContext *ctx, int idx) {
+    ctx->processes[idx].level = 0;
+    mlfq_enqueue(ctx->mlfq, idx, 0);
+}
+
+/**
+ * MLFQ step before dispatch: quantum expiry, then the periodic boost
+ */
+void mlfq_tick(SimulationContext *ctx) {
+    handle_rr_quantum_expiry(ctx);
+    if (ctx->current_time > 0 && ctx->current_time % MLFQ_BOOST_PERIOD == 0) mlfq_boost(ctx);
+}
+
+/**
+ * Run the main simulation loop of an initialized context to completion
+ */
+void run_simulation(SimulationContext *ctx) {
+    select_policy(ctx);
+    const Policy policy = ctx->policy;
+    // Main Simulation Loop
+    while (simulation_pending(ctx)) {
+        // Safety limit against runs that never finish (--max-time)
+        if (ctx->current_time >= ctx->max_time) {
+            ctx->stopped_early = true;
+            if (!ctx->quiet) {
+                fprintf(stderr, "Warning: stopping at time %d (--max-time) with processes still unfinished\n",
+                        ctx->current_time);
+            }
+            break;
+        }
+        if (ctx->checkpoints && ctx->current_time >= ctx->checkpoints->next_time) record_checkpoint(ctx);
+        long long mark = ctx->stats ? stats_now_ns() : 0;
+        if (ctx->stats) ctx->stats->loop_steps++;
+
+        // Handle new process arrivals
+        handle_arrivals(ctx);
+        stats_lap(ctx->stats, STAGE_ARRIVALS, &mark);
+
+        // Quantum expiry, MLFQ boosts or aging
+        if (policy.tick) policy.tick(ctx);
+        stats_lap(ctx->stats, STAGE_QUANTUM, &mark);
+
+        // Assign processes to idle CPUs
+        policy.assign(ctx);
+        stats_lap(ctx->stats, STAGE_DISPATCH, &mark);
+        
+        // Handle SRTF/MLFQ/PPRIO preemption
+        if (policy.preempt) policy.preempt(ctx);
+        stats_lap(ctx->stats, STAGE_PREEMPTION, &mark);
+
+        // Decide how far the clock can move before anything changes
+        int step = 1;
+        if (ctx->mode == SIM_EVENT) step = next_event_delta(ctx);
+        if (step > ctx->max_time - ctx->current_time) step = ctx->max_time - ctx->current_time;
+        if (ctx->runqueues) sample_runqueues(ctx, step);
+
+        if (ctx->parallel) {
+            // Timeline and execution per CPU block on the worker threads
+            execute_parallel(ctx, step);
+            stats_lap(ctx->stats, STAGE_EXECUTE, &mark);
+        } else {
+            // Update timeline
+            for (int c = 0; c < ctx->cpu_count; c++) {
+                int pid = (ctx->cpus[c].current_process != NULL) ? ctx->cpus[c].current_process->pid : -1;
+                timeline_record(&ctx->timeline, c, pid, ctx->current_time, ctx->current_time + step);
+            }
+            stats_lap(ctx->stats, STAGE_TIMELINE, &mark);
+
+            // Execute processes on CPUs
+            execute_processes(ctx, step);
+            stats_lap(ctx->stats, STAGE_EXECUTE, &mark);
+        }
+
+        // Advance time
+        ctx->current_time += step;
+    }
+
+    ctx->total_time = ctx->current_time; // Record total simulation time
+}
+
+/**
+ * Release everything a context owns outside its arena and detach it
+ *
+ * The process array stays with the caller, and the arena's storage is
+ * reclaimed by the caller's arena_reset() or free_arena().
+ */
+void cleanup_simulation(SimulationContext *ctx) {
+    cleanup_parallel(ctx);
+    cleanup_timeline(&ctx->timeline);
+    cleanup_runqueues(ctx);
+    free_int_list(&ctx->free_slots);
+    free_queue(&ctx->ready_queue);
+    ctx->arrived_indices = NULL;
+    ctx->arrival_order = NULL;
+    ctx->cpus = NULL;
+}
+
+/**
+ * Run the entire CPU scheduling simulation
+ */
+void simulate(Process *processes, int process_count, const Options *opts) {
+    int cpu_count = opts->cpu_counts.values[0];
+    Algorithm algorithm = (Algorithm)opts->algorithms.values[0];
+    int time_quantum = opts->quanta.values[0];
+    unsigned output = opts->output;
+
+    // Initialize simulation components
+    Arena arena;
+    init_arena(&arena);
+    SimulationContext ctx;
+    init_simulation(&ctx, processes, process_count, cpu_count, algorithm, time_quantum, opts->mode,
+                    opts->storage, &arena);
+    init_aging(&ctx, opts->aging);
+    init_overhead(&ctx, opts->switch_cost, opts->migration_cost);
+    init_affinity(&ctx, opts->affinity);
+    init_horizon(&ctx, opts->max_time);
+    ctx.trace = opts->trace;
+
+    SimStats stats;
+    if (opts->stats) {
+        init_stats(&stats, cpu_count);
+        attach_stats(&ctx, &stats);
+    }
+    LatencyMetrics latency;
+    if (opts->percentiles) {
+        init_latency(&latency);
+        ctx.latency = &latency;
+    }
+    if (opts->placement != PLACE_GLOBAL) init_runqueues(&ctx, opts->placement);
+    init_parallel(&ctx, opts->threads);
+    int resumed_at = opts->resume_file ? resume_simulation(&ctx, opts->resume_file) : 0;
+    CheckpointLog checkpoints;
+    if (opts->checkpoint_file) init_checkpoints(&ctx, &checkpoints, opts->checkpoint_interval);
+    
+    // Display simulation header
+    if (output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) {
+        printf("\nStarting simulation with %s on %d CPU(s)%s\n", 
+               algorithm_name(algorithm),
+               cpu_count, 
+               algorithm_uses_quantum(algorithm) ? ", Quantum=" : "");
+        if (algorithm_uses_quantum(algorithm)) printf("%d", time_quantum);
+        printf("\n");
+        if (opts->resume_file) {
+            if (resumed_at > 0) printf("Resuming from the checkpoint at time %d in %s\n", resumed_at, opts->resume_file);
+            else printf("No usable checkpoint in %s; simulating from time 0\n", opts->resume_file);
+        }
+    }
+
+    run_simulation(&ctx);
+    print_results(processes, process_count, ctx.cpus, cpu_count, &ctx.timeline, ctx.total_time, output,
+                  &opts->window, ctx.stats, ctx.latency, ctx.runqueues,
+                  opts->affinity >= 0 || opts->migration_cost > 0);
+    if (opts->dump_file) dump_results(opts->dump_file, &ctx);
+    if (opts->checkpoint_file) {
+        write_checkpoints(opts->checkpoint_file, &ctx);
+        free_checkpoints(&checkpoints);
+    }
+
+    // Cleanup
+    cleanup_simulation(&ctx);
+    free_arena(&arena);
+    if (opts->stats) free_stats(&stats);
+    if (opts->percentiles) free_latency(&latency);
+}
+
+/************************* RESULTS DISPLAY *************************/
+
+/**
+ * Append `value` left-justified in at least `width` characters (like "%-*d")
+ */
+void buffer_append_int(ByteBuffer *buffer, int value, int width) {
+    char digits[16];
+    int n = 0;
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[n++] = '-';
+
+    char text[32];
+    int length = 0;
+    while (n > 0) text[length++] = digits[--n];
+    while (length < width && length < (int)sizeof(text)) text[length++] = ' ';
+    buffer_append(buffer, text, length);
+}
+
+/**
+ * Append one timeline cell: a colored PID, or the idle marker
+ */
+void buffer_append_cell(ByteBuffer *buffer, int pid, int width) {
+    if (pid == -1) {
+        buffer_append(buffer, ".", 1);
+        for (int k = 1; k < width; k++) buffer_append(buffer, " ", 1);
+        return;
+    }
+    const char *color = get_color_for_pid(pid);
+    buffer_append(buffer, color, strlen(color));
+    buffer_append_int(buffer, pid, width);
+    buffer_append(buffer, COLOR_RESET, strlen(COLOR_RESET));
+}
+
+/**
+ * Order summary shares by PID, then by when they occurred
+ */
+int compare_shares(const void *a, const void *b) {
+    const TimelineShare *x = (const TimelineShare *)a;
+    const TimelineShare *y = (const TimelineShare *)b;
+    if (x->pid != y->pid) return x->pid < y->pid ? -1 : 1;
+    return x->first - y->first;
+}
+
+/**
+ * PID (or -1 for idle) that held the CPU longest among `shares`; ties go to the earliest
+ */
+int dominant_pid(TimelineShare *shares, int count) {
+    if (count == 1) return shares[0].pid;
+    qsort(shares, count, sizeof(TimelineShare), compare_shares);
+    int best_pid = -1, best_length = -1, best_first = 0;
+    for (int k = 0; k < count;) {
+        int pid = shares[k].pid, first = shares[k].first, length = 0;
+        while (k < count && shares[k].pid == pid) length += shares[k++].length;
+        if (length > best_length || (length == best_length && first < best_first)) {
+            best_pid = pid;
+            best_length = length;
+            best_first = first;
+        }
+    }
+    return best_pid;
+}
+
+/**
+ * Print the execution timeline visualization
+ *
+ * Only `window` is rendered, so the work follows the window, not the run:
+ * RLE cursors start by binary search and every line block is formatted into
+ * one buffer and written with a single fwrite(). With a bucket above 1 each
+ * column summarizes that many time units by the PID that ran the longest.
+ */
+void print_timeline(const Timeline *timeline, int total_time, Process *processes, int process_count, int cpu_count,
+                    const TimelineWindow *window) {
+    printf("\nExecution Timeline:\n");
+    if (timeline->storage == TIMELINE_NONE) {
+        printf("(not recorded; run with --timeline grid or rle to keep it)\n");
+        return;
+    }
+    int first_t = window->start;
+    int last_t = window->end < 0 || window->end > total_time ? total_time : window->end;
+    int bucket = window->bucket;
+    bool full = first_t == 0 && last_t == total_time && bucket == 1;
+    if (first_t >= last_t) {
+        printf("(nothing to show from time %d; the run lasted %d time units)\n", first_t, total_time);
+        return;
+    }
+    if (!full) printf("Time %d to %d, %d time unit(s) per column\n", first_t, last_t - 1, bucket);
+
+    int time_units_per_line = (TIMELINE_WIDTH - 5) / TIME_UNIT_WIDTH;
+    if (time_units_per_line <= 0) time_units_per_line = 1; // Ensure at least 1 unit per line
+    long span = (long)time_units_per_line * bucket;
+    int time_segments = (int)((last_t - first_t + span - 1) / span);
+
+    // Print color key (a window lists only the processes that ran in it)
+    printf("\nColor Key:\n");
+    int shown = 0;
+    for (int i = 0; i < process_count; i++) {
+        const Process *p = &processes[i];
+        if (!full && (p->start_time == -1 || p->start_time >= last_t ||
+                      (p->finish_time != -1 && p->finish_time <= first_t))) continue;
+        if (shown > 0 && shown % 8 == 0) printf("\n");
+        printf("%sPID %-2d%s ", get_color_for_pid(p->pid), p->pid, COLOR_RESET);
+        shown++;
+    }
+    printf("\n");
+
+    // One lookup cursor per CPU, positioned at the window
+    int *cursors = (int *)malloc(cpu_count * sizeof(int));
+    int share_capacity = bucket < last_t - first_t ? bucket : last_t - first_t; // Runs per column at most
+    TimelineShare *shares = (TimelineShare *)malloc(share_capacity * sizeof(TimelineShare));
+    if (!cursors || !shares) {
+        perror("Failed to allocate timeline cursors");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < cpu_count; c++) cursors[c] = timeline_seek(timeline, c, first_t);
+    ByteBuffer out = {NULL, 0, 0};
+
+    // Print timeline in segments
+    for (int segment = 0; segment < time_segments; segment++) {
+        int start_t = (int)(first_t + segment * span);
+        int end_t = start_t + span < last_t ? (int)(start_t + span) : last_t;
+        out.size = 0;
+
+        char header[64];
+        int length = snprintf(header, sizeof(header), "\nTime %d to %d:\n", start_t, end_t - 1);
+        buffer_append(&out, header, length);
+
+        // Time markers
+        buffer_append(&out, "Time: ", 6);
+        for (long t = start_t; t < end_t; t += bucket) {
+            buffer_append_int(&out, (int)t, TIME_UNIT_WIDTH); // Print time marker for each column
+        }
+        buffer_append(&out, "\n", 1);
+
+        // CPU timelines
+        for (int c = 0; c < cpu_count; c++) {
+            buffer_append(&out, "CPU", 3);
+            buffer_append_int(&out, c, 2);
+            buffer_append(&out, " ", 1);
+            for (int t = start_t; t < end_t;) {
+                int stop = end_t - t > bucket ? t + bucket : end_t;
+                int count = 0, pid;
+                for (int u = t; u < stop; count++) {
+                    int run_end = timeline_run_end(timeline, c, u, stop, &cursors[c], &pid);
+                    shares[count].pid = pid;
+                    shares[count].length = run_end - u;
+                    shares[count].first = count;
+                    u = run_end;
+                }
+                buffer_append_cell(&out, dominant_pid(shares, count), TIME_UNIT_WIDTH);
+                t = stop;
+            }
+            buffer_append(&out, "\n", 1);
+        }
+        fwrite(out.data, 1, out.size, stdout);
+    }
+    free(out.data);
+    free(shares);
+    free(cursors);
+}
+
+/**
+ * Compute every reported statistic once from a finished run
+ *
+ * All printers read from the returned struct instead of re-deriving
+ * turnaround and waiting times themselves. Free with free_results().
+ */
+void compute_results(const Process *processes, int process_count, const CPU *cpus, int cpu_count,
+                     int total_time, SimulationResults *results) {
+    results->process_count = process_count;
+    results->cpu_count = cpu_count;
+    results->total_time = total_time;
+    results->processes = (ProcessResult *)malloc(process_count * sizeof(ProcessResult));
+    results->cpus = (CpuResult *)malloc(cpu_count * sizeof(CpuResult));
+    if (!results->processes || !results->cpus) {
+        perror("Failed to allocate results");
+        exit(EXIT_FAILURE);
+    }
+
+    double total_turnaround = 0.0, total_waiting = 0.0, total_response = 0.0;
+    int valid_stats_count = 0;
+
+    for (int i = 0; i < process_count; i++) {
+        const Process *p = &processes[i];
+        ProcessResult *r = &results->processes[i];
+        r->pid = p->pid;
+        r->arrival_time = p->arrival_time;
+        r->burst_time = p->burst_time;
+        r->priority = p->priority;
+        r->start_time = p->start_time;
+        r->finish_time = p->finish_time;
+        r->response_time = p->response_time;
+        r->completed = p->finish_time != -1;
+        r->turnaround_time = 0;
+        r->waiting_time = 0;
+
+        if (r->completed) { // Only calculate for completed processes
+            r->turnaround_time = p->finish_time - p->arrival_time;
+            r->waiting_time = p->waiting_time; // Accumulated at each dispatch
+
+            total_turnaround += r->turnaround_time;
+            total_waiting += r->waiting_time;
+            total_response += p->response_time;
+            valid_stats_count++;
+        }
+    }
+
+    results->completed_count = valid_stats_count;
+    results->avg_turnaround = valid_stats_count ? total_turnaround / valid_stats_count : 0.0;
+    results->avg_waiting = valid_stats_count ? total_waiting / valid_stats_count : 0.0;
+    results->avg_response = valid_stats_count ? total_response / valid_stats_count : 0.0;
+
+    long busy = 0, total = 0, overhead = 0;
+    for (int c = 0; c < cpu_count; c++) {
+        CpuResult *r = &results->cpus[c];
+        r->id = cpus[c].id;
+        r->busy_time = cpus[c].busy_time;
+        r->idle_time = cpus[c].idle_time;
+        r->overhead_time = cpus[c].overhead_time;
+        r->same_cpu_dispatches = cpus[c].same_cpu_dispatches;
+        r->migrated_dispatches = cpus[c].migrated_dispatches;
+        r->utilization = 0.0;
+        int cpu_total_time = r->busy_time + r->idle_time;
+        if (cpu_total_time > 0) {
+            r->utilization = 100.0 * r->busy_time / cpu_total_time;
+        }
+        busy += r->busy_time;
+        total += cpu_total_time;
+        overhead += r->overhead_time;
+    }
+    results->utilization = total > 0 ? 100.0 * busy / total : 0.0;
+    results->overhead_time = overhead;
+    results->stats = NULL;
+    results->latency = NULL;
+    results->runqueues = NULL;
+    results->locality = false;
+}
+
+/**
+ * Release the arrays of a results struct
+ */
+void free_results(SimulationResults *results) {
+    free(results->processes);
+    free(results->cpus);
+    results->processes = NULL;
+    results->cpus = NULL;
+}
+
+/**
+ * Print detailed process statistics
+ */
+void print_process_stats(const SimulationResults *results) {
+    printf("\nProcess Statistics:\n");
+    printf("%-6s %-7s %-7s %-7s %-7s %-7s %-7s %-7s\n",
+           "PID", "Arrival", "Burst", "Start", "Finish", "Turn.", "Waiting", "Resp.");
+    printf("----------------------------------------------------------------\n");
+
+    for (int i = 0; i < results->process_count; i++) {
+        const ProcessResult *p = &results->processes[i];
+        if (p->completed) {
+            printf("%-6d %-7d %-7d %-7d %-7d %-7d %-7d %-7d\n",
+                   p->pid, p->arrival_time, p->burst_time,
+                   p->start_time, p->finish_time, p->turnaround_time, p->waiting_time, p->response_time);
+        } else {
+            printf("%-6d %-7d %-7d %-7s %-7s %-7s %-7s %-7s\n",
+                   p->pid, p->arrival_time, p->burst_time,
+                   (p->start_time == -1 ? "N/A" : "-"), "N/A", "N/A", "N/A",
+                   (p->response_time == -1 ? "N/A" : "-"));
+        }
+    }
+    printf("----------------------------------------------------------------\n");
+}
 
 /**
- * Get a color code for a process ID for colorized output
+ * Print CPU usage statistics
  */
-const char* get_color_for_pid(int pid) {
-    if (pid < 0) return COLOR_RESET; // Idle
-    return PROCESS_COLORS[pid % NUM_PROCESS_COLORS];
+void print_cpu_stats(const SimulationResults *results) {
+    printf("\nCPU Statistics:\n");
+    printf("%-6s %-9s %-9s %-12s\n", "CPU ID", "Busy Time", "Idle Time", "Utilization");
+    printf("------------------------------------------\n");
+    for (int i = 0; i < results->cpu_count; i++) {
+        const CpuResult *cpu = &results->cpus[i];
+        printf("%-6d %-9d %-9d %-11.2f%%\n", cpu->id, cpu->busy_time, cpu->idle_time, cpu->utilization);
+    }
+    printf("------------------------------------------\n");
+    if (results->overhead_time > 0) {
+        printf("Switch and migration overhead (part of busy time):\n");
+        for (int i = 0; i < results->cpu_count; i++) {
+            const CpuResult *cpu = &results->cpus[i];
+            printf("  CPU %-2d %d time units (%.2f%% of its time)\n", cpu->id, cpu->overhead_time,
+                   overhead_share(cpu));
+        }
+    }
+    if (results->locality) {
+        printf("Dispatch locality (jobs that ran before):\n");
+        for (int i = 0; i < results->cpu_count; i++) {
+            const CpuResult *cpu = &results->cpus[i];
+            printf("  CPU %-2d %d on the same CPU, %d migrated here\n", cpu->id, cpu->same_cpu_dispatches,
+                   cpu->migrated_dispatches);
+        }
+    }
 }
 
 /**
- * Get the algorithm name as a string
+ * Overhead share of a CPU's total time, in percent (comparable to its utilization)
  */
-const char* algorithm_name(Algorithm algorithm) {
-    switch (algorithm) {
-        case FCFS: return "First-Come, First-Served";
-        case RR:   return "Round Robin";
-        case SRTF: return "Shortest Remaining Time First";
-        case SJF:  return "Shortest Job First";
-        default:   return "Unknown Algorithm";
-    }
+double overhead_share(const CpuResult *cpu) {
+    int cpu_total_time = cpu->busy_time + cpu->idle_time;
+    return cpu_total_time > 0 ? 100.0 * cpu->overhead_time / cpu_total_time : 0.0;
 }
 
 /**
- * Parse command line arguments
+ * Print average performance metrics
  */
-void parse_arguments(int argc, char *argv[], Algorithm *algorithm, int *cpu_count, 
-                    int *time_quantum, char **input_file) {
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
-            i++;
-            if (strcmp(argv[i], "FCFS") == 0) *algorithm = FCFS;
-            else if (strcmp(argv[i], "RR") == 0) *algorithm = RR;
-            else if (strcmp(argv[i], "SRTF") == 0) *algorithm = SRTF;
-            else if (strcmp(argv[i], "SJF") == 0) *algorithm = SJF;
-            // Default is FCFS
-        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
-            *cpu_count = atoi(argv[++i]);
-            if (*cpu_count <= 0) *cpu_count = 1; // Ensure at least 1 CPU
-        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
-            *time_quantum = atoi(argv[++i]);
-            if (*time_quantum <= 0) *time_quantum = DEFAULT_TIME_QUANTUM;
-        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
-            *input_file = argv[++i];
-        } else {
-            fprintf(stderr, "Usage: %s -f <file> [-a <FCFS|RR|SRTF|SJF>] [-c <cpus>] [-q <quantum>]\n", argv[0]);
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    if (!(*input_file)) {
-        fprintf(stderr, "Error: Input file required. Use -f <filename>\n");
-        exit(EXIT_FAILURE);
+void print_average_stats(const SimulationResults *results) {
+    if (results->completed_count > 0) {
+        printf("\nAverage Statistics (for %d completed processes):\n", results->completed_count);
+        printf("  Average Turnaround Time: %.2f\n", results->avg_turnaround);
+        printf("  Average Waiting Time:    %.2f\n", results->avg_waiting);
+        printf("  Average Response Time:   %.2f\n", results->avg_response);
+    } else {
+        printf("\nNo processes completed. Cannot calculate average statistics.\n");
     }
 }
 
+/**
+ * Generate CSV output for automated testing
+ */
+void print_csv_output(const SimulationResults *results) {
+    printf("\n\n--- CSV Output ---\n");
+    
+    // Process stats CSV
+    print_csv_process_header();
+    for (int i = 0; i < results->process_count; i++) {
+        print_csv_process_row(&results->processes[i]);
+    }
 
+    print_csv_tail(results);
+}
 
-/************************* PROCESS LOADING *************************/
+/**
+ * Print the heading of the per-process CSV block
+ */
+void print_csv_process_header(void) {
+    printf("\nProcess Stats (CSV):\n");
+    printf("PID,Arrival,Burst,Priority,Start,Finish,Turnaround,Waiting,Response\n");
+}
 
 /**
- * Load processes from a file
- * 
- * Expected format:
- * <PID> <arrival_time> <burst_time> [priority]
- * 
- * Lines starting with # are treated as comments
+ * Print one per-process CSV row
  */
-void load_processes(const char *filename, Process **processes_ptr, int *count) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("Error opening process file");
-        exit(EXIT_FAILURE);
+void print_csv_process_row(const ProcessResult *p) {
+    if (p->completed) {
+        printf("%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+               p->pid, p->arrival_time, p->burst_time, p->priority,
+               p->start_time, p->finish_time, p->turnaround_time, p->waiting_time, p->response_time);
+    } else {
+         printf("%d,%d,%d,%d,%s,%s,%s,%s,%s\n",
+               p->pid, p->arrival_time, p->burst_time, p->priority,
+               "N/A", "N/A", "N/A", "N/A", "N/A");
     }
+}
 
-    // Count valid lines first
-    int process_count = 0;
-    char line[MAX_LINE_LENGTH];
-    while (fgets(line, sizeof(line), file)) {
-        if (line[0] != '#' && line[0] != '\n' && strspn(line, " \t\n\r") != strlen(line)) {
-            int pid, arrival, burst;
-            if (sscanf(line, "%d %d %d", &pid, &arrival, &burst) == 3) {
-                process_count++;
-            }
+/**
+ * Print the CPU and average CSV blocks and the end marker
+ */
+void print_csv_tail(const SimulationResults *results) {
+    // CPU stats CSV
+    printf("\nCPU Stats (CSV):\n");
+    printf("CPU_ID,BusyTime,IdleTime,Utilization%%\n");
+    for (int i = 0; i < results->cpu_count; i++) {
+        const CpuResult *cpu = &results->cpus[i];
+        printf("%d,%d,%d,%.2f\n", cpu->id, cpu->busy_time, cpu->idle_time, cpu->utilization);
+    }
+    if (results->overhead_time > 0) {
+        printf("\nCPU Overhead Stats (CSV):\n");
+        printf("CPU_ID,OverheadTime,Overhead%%\n");
+        for (int i = 0; i < results->cpu_count; i++) {
+            const CpuResult *cpu = &results->cpus[i];
+            printf("%d,%d,%.2f\n", cpu->id, cpu->overhead_time, overhead_share(cpu));
         }
     }
-
-    if (process_count == 0) {
-        *processes_ptr = NULL;
-        *count = 0;
-        fclose(file);
-        printf("Warning: No valid processes found in %s\n", filename);
-        return;
+    if (results->locality) {
+        printf("\nCPU Affinity Stats (CSV):\n");
+        printf("CPU_ID,SameCPUDispatches,MigratedDispatches\n");
+        for (int i = 0; i < results->cpu_count; i++) {
+            const CpuResult *cpu = &results->cpus[i];
+            printf("%d,%d,%d\n", cpu->id, cpu->same_cpu_dispatches, cpu->migrated_dispatches);
+        }
     }
 
-    // Allocate memory
-    *processes_ptr = (Process *)malloc(process_count * sizeof(Process));
-    if (!(*processes_ptr)) {
-        perror("Memory allocation failed for processes");
-        fclose(file);
-        exit(EXIT_FAILURE);
+    printf("\nAverage Stats (CSV):\n");
+    printf("AvgTurnaround,AvgWaiting,AvgResponse\n");
+    if (results->completed_count > 0) {
+        printf("%.2f,%.2f,%.2f\n",
+               results->avg_turnaround,
+               results->avg_waiting,
+               results->avg_response);
+    } else {
+        printf("N/A,N/A,N/A\n");
     }
+    if (results->latency) print_csv_latency(results->latency);
+    if (results->runqueues) print_csv_runqueues(results->runqueues, results->total_time);
+    if (results->stats) print_csv_stats(results->stats);
+    printf("--- End CSV Output ---\n");
+}
 
-    // Read process data
-    rewind(file);
-    int i = 0;
-    while (fgets(line, sizeof(line), file) && i < process_count) {
-        if (line[0] == '#' || line[0] == '\n' || strspn(line, " \t\n\r") == strlen(line)) continue;
-
-        int pid, arrival, burst, priority = 0; // Default priority
-        int items_read = sscanf(line, "%d %d %d %d", &pid, &arrival, &burst, &priority);
-
-        if (items_read >= 3) { // Need at least PID, arrival, burst
-            Process *p = &(*processes_ptr)[i];
-            p->pid = pid;
-            p->arrival_time = arrival;
-            p->burst_time = burst;
-            p->priority = (items_read == 4) ? priority : 0; // Assign priority if read
-            p->remaining_time = burst;
-            p->state = WAITING;
-            p->start_time = -1;
-            p->finish_time = -1;
-            p->waiting_time = 0;
-            p->quantum_used = 0;
-            p->response_time = -1;
-            i++;
-        }
+/**
+ * Print the --stats counters in human-readable form
+ */
+void print_sim_stats(const SimStats *stats) {
+    static const char *stage_names[STAGE_COUNT] = {
+        "Arrivals", "Quantum expiry", "Dispatch", "Preemption", "Timeline", "Execute"
+    };
+    unsigned long switches = 0;
+    for (int c = 0; c < stats->cpu_count; c++) switches += stats->context_switches[c];
+
+    printf("\nScheduler Statistics:\n");
+    printf("  Loop steps:              %lu\n", stats->loop_steps);
+    printf("  Enqueues / dequeues:     %lu / %lu\n", stats->enqueues, stats->dequeues);
+    printf("  Queue scan steps:        %lu (remaining), %lu (arrival), %lu (priority)\n",
+           stats->scan_steps[ORDER_REMAINING], stats->scan_steps[ORDER_ARRIVAL], stats->scan_steps[ORDER_PRIORITY]);
+    printf("  Preemptions:             %lu\n", stats->preemptions);
+    printf("  Quantum expiries:        %lu\n", stats->quantum_expiries);
+    printf("  Aging steps:             %lu\n", stats->aging_steps);
+    printf("  Idle-CPU scans:          %lu\n", stats->idle_scans);
+    printf("  Context switches:        %lu\n", switches);
+
+    printf("\n%-6s %-10s %-16s\n", "CPU ID", "Dispatches", "Context Switches");
+    printf("----------------------------------\n");
+    for (int c = 0; c < stats->cpu_count; c++) {
+        printf("%-6d %-10lu %-16lu\n", c, stats->dispatches[c], stats->context_switches[c]);
     }
-    fclose(file);
+    printf("----------------------------------\n");
 
-    *count = i; // Actual number of processes successfully read
-    printf("Loaded %d processes from %s\n", *count, filename);
+    printf("\nStage Timings (us):\n");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        printf("  %-16s %10.1f\n", stage_names[s], stats->stage_ns[s] / 1000.0);
+    }
 }
 
-/************************* SIMULATION COMPONENTS *************************/
-
 /**
- * Handle process arrivals at the current time
+ * Print the --stats counters as CSV blocks
  */
-void handle_arrivals(Process *processes, int process_count, int current_time, Algorithm algorithm,
-                   int *arrived_indices, int *arrival_count) {
-    // TODO: Find and record processes that have arrived at the current time
-    // Remember to handle state transitions appropriately for each algorithm type
-    // FCFS = 0, RR = 1, SRTF (preemptive) = 2, SJF (non-preemptive) = 3
-    if (processes == NULL || arrived_indices == NULL || arrival_count == NULL){
-        perror("There was a variable that was NULL in the handle_arrivals function");
-        return;
+void print_csv_stats(const SimStats *stats) {
+    static const char *stage_keys[STAGE_COUNT] = {
+        "Arrivals", "Quantum", "Dispatch", "Preemption", "Timeline", "Execute"
+    };
+    unsigned long switches = 0;
+    for (int c = 0; c < stats->cpu_count; c++) switches += stats->context_switches[c];
+
+    printf("\nScheduler Stats (CSV):\n");
+    printf("Counter,Value\n");
+    printf("LoopSteps,%lu\n", stats->loop_steps);
+    printf("Enqueues,%lu\n", stats->enqueues);
+    printf("Dequeues,%lu\n", stats->dequeues);
+    printf("ScanStepsRemaining,%lu\n", stats->scan_steps[ORDER_REMAINING]);
+    printf("ScanStepsArrival,%lu\n", stats->scan_steps[ORDER_ARRIVAL]);
+    printf("ScanStepsPriority,%lu\n", stats->scan_steps[ORDER_PRIORITY]);
+    printf("Preemptions,%lu\n", stats->preemptions);
+    printf("QuantumExpiries,%lu\n", stats->quantum_expiries);
+    printf("AgingSteps,%lu\n", stats->aging_steps);
+    printf("IdleCpuScans,%lu\n", stats->idle_scans);
+    printf("ContextSwitches,%lu\n", switches);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        printf("Stage%sNs,%lld\n", stage_keys[s], stats->stage_ns[s]);
     }
 
-    // need to loop through the current processes, check to see if the time matches with the current time and check to see if the state is in WAITING
-    for (int i = 0; i < process_count; i++){
+    printf("\nCPU Switch Stats (CSV):\n");
+    printf("CPU_ID,Dispatches,ContextSwitches\n");
+    for (int c = 0; c < stats->cpu_count; c++) {
+        printf("%d,%lu,%lu\n", c, stats->dispatches[c], stats->context_switches[c]);
+    }
+}
 
-        if (processes[i].arrival_time == current_time){
+/**
+ * Display the simulation results selected by `output`
+ */
+void print_results(Process *processes, int process_count, CPU *cpus, int cpu_count, const Timeline *timeline,
+                   int total_time, unsigned output, const TimelineWindow *window, const SimStats *stats,
+                   const LatencyMetrics *latency, const RunQueues *runqueues, bool locality) {
+    SimulationResults results;
+    compute_results(processes, process_count, cpus, cpu_count, total_time, &results);
+    results.stats = stats;
+    results.latency = latency;
+    results.runqueues = runqueues;
+    results.locality = locality;
+
+    if (output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) printf("\n--- Simulation Results ---\n");
 
-            if (*arrival_count < MAX_PROCESSES){  
-                processes[i].state = READY;         
-                arrived_indices[*arrival_count] = i;
-                processes[i].quantum_used = 0;          // for RR
-                (*arrival_count)++; 
-            }
-        }
+    // Print visual timeline
+    if (output & OUTPUT_TIMELINE) print_timeline(timeline, total_time, processes, process_count, cpu_count, window);
+    
+    // Print detailed statistics
+    if (output & OUTPUT_SUMMARY) {
+        print_process_stats(&results);
+        print_cpu_stats(&results);
+        print_average_stats(&results);
+        if (latency) print_latency(latency);
+        if (stats) print_sim_stats(stats);
+        if (runqueues) print_runqueue_stats(runqueues, total_time);
     }
     
-    // need to ask what to do here (how do I add to queue and the other data structures. If not doing this, what do I do in this part?)
-    for (int idx = 0; idx < *arrival_count; idx++){
+    // Print CSV output for automated testing
+    if (output & OUTPUT_CSV) print_csv_output(&results);
 
-        // FCFS
-        if (algorithm == FCFS){
-            //add the index of the process (in processes, in the FCSFQ)
-            enqueue_priority2(&FCFSQ , arrived_indices[idx], processes);
-        }
-        else if (algorithm == RR){
-            // do nothing for RR (it enqueues in simulate)
-        }
-        // SRTF (preemptive)
-        else if (algorithm == SRTF){
+    free_results(&results);
+}
 
-            enqueue_priority(&FCFSQ , arrived_indices[idx] , processes);
-        }
-        else if (algorithm == SJF){ //SJF
-            enqueue_priority(&FCFSQ , arrived_indices[idx] , processes);
+/************************* CHECKPOINTS *************************/
+
+/**
+ * Append bytes to a buffer, doubling its capacity as needed
+ */
+void buffer_append(ByteBuffer *buffer, const void *data, size_t bytes) {
+    if (buffer->size + bytes > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (buffer->size + bytes > capacity) capacity *= 2;
+        char *temp = (char *)realloc(buffer->data, capacity);
+        if (!temp) {
+            perror("Failed to expand checkpoint buffer");
+            exit(EXIT_FAILURE);
         }
-        else {
-            // algorithm number is incorrect (do something)
-            perror("Wrong algorithm type");
-        }   
+        buffer->data = temp;
+        buffer->capacity = capacity;
     }
+    memcpy(buffer->data + buffer->size, data, bytes);
+    buffer->size += bytes;
 }
 
 /**
- * Handle quantum expiration for Round Robin scheduling
+ * Number of ready queues a context holds, in the order context_queue() returns them
  */
-void handle_rr_quantum_expiry(Process *processes, CPU *cpus, int cpu_count, int time_quantum,
-                           ReadyQueue *ready_queue, int current_time) {
-    // TODO: Move Round Robin processes back to the queue when their quantum expires
+int context_queue_count(const SimulationContext *ctx) {
+    return 1 + (ctx->mlfq ? MLFQ_LEVELS : 0) + (ctx->aging_period > 0) +
+           (ctx->runqueues ? ctx->runqueues->count : 0);
+}
 
-    (void) ready_queue;
-    (void) current_time;
-    // use FCFSQ
-    // loop through the CPU list and check to see if it has been running for too
-    for (int i = 0; i < cpu_count; i++){
+/**
+ * The k-th ready queue of a context: the global queue, MLFQ levels, the aging FIFO, per-CPU queues
+ */
+ReadyQueue *context_queue(SimulationContext *ctx, int k) {
+    if (k == 0) return &ctx->ready_queue;
+    k--;
+    if (ctx->mlfq) {
+        if (k < MLFQ_LEVELS) return &ctx->mlfq->levels[k];
+        k -= MLFQ_LEVELS;
+    }
+    if (ctx->aging_period > 0) {
+        if (k == 0) return &ctx->aging;
+        k--;
+    }
+    return &ctx->runqueues->queues[k];
+}
 
-        if (cpus[i].current_process == NULL){
-            continue;
-        }
+/**
+ * Start collecting checkpoints every `interval` time units after the current time
+ */
+void init_checkpoints(SimulationContext *ctx, CheckpointLog *log, int interval) {
+    log->interval = interval;
+    log->next_time = (ctx->current_time / interval + 1) * interval;
+    log->count = 0;
+    log->frames.data = NULL;
+    log->frames.size = 0;
+    log->frames.capacity = 0;
+    ctx->checkpoints = log;
+}
 
-        // if there is still time left and if it is still running
-        if (cpus[i].current_process->remaining_time > 0 && cpus[i].current_process->state == RUNNING){
+/**
+ * Append a frame with everything the loop needs to continue from the current time
+ *
+ * Only processes that already arrived can differ from their initial or final
+ * state, so a frame costs O(live jobs + queued entries), not O(workload).
+ */
+void record_checkpoint(SimulationContext *ctx) {
+    CheckpointLog *log = ctx->checkpoints;
+    ByteBuffer *out = &log->frames;
+    size_t start = out->size;
+
+    CheckpointFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.time = ctx->current_time;
+    frame.completed_count = ctx->completed_count;
+    frame.queue_count = context_queue_count(ctx);
+    buffer_append(out, &frame, sizeof(frame));
+
+    // arrival_cursor covers exactly the processes that arrived before now
+    for (int k = 0; k < ctx->arrival_cursor; k++) {
+        int i = ctx->arrival_order[k];
+        if (ctx->processes[i].state == COMPLETED) continue;
+        CheckpointProcess live;
+        memset(&live, 0, sizeof(live));
+        live.process_idx = i;
+        live.state = ctx->processes[i];
+        buffer_append(out, &live, sizeof(live));
+        frame.live_count++;
+    }
 
-            // get the current process
-            Process *curr = cpus[i].current_process;
-            
-            // if the quantum used is greater than the max quantum time, put it to the back of the list
-            if (curr->quantum_used >= time_quantum){
+    for (int c = 0; c < ctx->cpu_count; c++) {
+        const CPU *cpu = &ctx->cpus[c];
+        CheckpointCpu saved;
+        saved.process_idx = cpu->current_process ? (int32_t)(cpu->current_process - ctx->processes) : -1;
+        saved.last_idx = cpu->idx;
+        saved.idle_time = cpu->idle_time;
+        saved.busy_time = cpu->busy_time;
+        saved.last_pid = cpu->last_pid;
+        saved.overhead_left = cpu->overhead_left;
+        saved.overhead_time = cpu->overhead_time;
+        saved.same_cpu_dispatches = cpu->same_cpu_dispatches;
+        saved.migrated_dispatches = cpu->migrated_dispatches;
+        saved.reserved = 0;
+        buffer_append(out, &saved, sizeof(saved));
+    }
 
-                // resetting time quantum
-                curr->quantum_used = 0;
-                curr->state = READY;
-                int curr_idx = curr - processes;
-                enqueue(&FCFSQ, curr_idx);
-                cpus[i].current_process = NULL;   
+    for (int k = 0; k < frame.queue_count; k++) {
+        const ReadyQueue *q = context_queue(ctx, k);
+        CheckpointQueue saved;
+        memset(&saved, 0, sizeof(saved));
+        saved.size = q->size;
+        saved.ordered = q->ordered;
+        saved.order = q->order;
+        saved.next_seq = q->next_seq;
+        buffer_append(out, &saved, sizeof(saved));
+        if (q->ordered) {
+            buffer_append(out, q->entries, q->size * sizeof(QueueEntry));
+        } else {
+            for (int e = 0; e < q->size; e++) {
+                buffer_append(out, &q->entries[(q->front + e) % q->capacity], sizeof(QueueEntry));
             }
         }
     }
-    // (void)current_time; // Explicitly mark as unused
+
+    if (ctx->runqueues) {
+        const RunQueues *rq = ctx->runqueues;
+        int64_t next_cpu = rq->next_cpu;
+        buffer_append(out, &next_cpu, sizeof(next_cpu));
+        for (int c = 0; c < rq->count; c++) {
+            CheckpointRunQueue saved;
+            saved.steals = rq->steals[c];
+            saved.length_time = rq->length_time[c];
+            saved.max_length = rq->max_length[c];
+            saved.reserved = 0;
+            buffer_append(out, &saved, sizeof(saved));
+        }
+    }
+
+    frame.bytes = out->size - start;
+    memcpy(out->data + start, &frame, sizeof(frame));
+    log->count++;
+    log->next_time = (ctx->current_time / log->interval + 1) * log->interval;
 }
 
 /**
- * Implement preemptive scheduling for SRTF
+ * Write the collected frames with the run's configuration and final state (--checkpoint)
  */
-void handle_srtf_preemption(Process *processes, int process_count, CPU *cpus, int cpu_count, int current_time) {
-    // TODO: Implement preemption logic for SRTF: replace running processes if a ready process is shorter
-    // Consider priority as a tiebreaker when remaining times are equal
-    (void) process_count;
-
-    if (processes == NULL || cpus == NULL){
-        perror("There is an issue at the beginning of handle_srtf_preemption()");
-    }
-    int idx = dequeue(&FCFSQ);
-    if (idx == -1) return;
+void write_checkpoints(const char *filename, const SimulationContext *ctx) {
+    FILE *f = open_output_file(filename);
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, BINARY_MAGIC_LENGTH);
+    header.process_size = sizeof(Process);
+    header.entry_size = sizeof(QueueEntry);
+    header.algorithm = ctx->algorithm;
+    header.cpu_count = ctx->cpu_count;
+    header.time_quantum = ctx->time_quantum;
+    header.aging = ctx->aging_period;
+    header.placement = ctx->runqueues ? ctx->runqueues->placement : PLACE_GLOBAL;
+    header.process_count = ctx->process_count;
+    header.total_time = ctx->total_time;
+    header.checkpoint_count = ctx->checkpoints->count;
+    header.has_timeline = ctx->timeline.storage != TIMELINE_NONE;
+    header.switch_cost = ctx->switch_cost;
+    header.migration_cost = ctx->migration_cost;
+    header.affinity = ctx->affinity_wait;
+    header.segment_count = write_timeline_runs(&ctx->timeline, ctx->total_time, NULL);
+    fwrite(&header, sizeof(header), 1, f);
+
+    fwrite(ctx->processes, sizeof(Process), ctx->process_count, f);
+    write_timeline_runs(&ctx->timeline, ctx->total_time, f);
+    fwrite(ctx->checkpoints->frames.data, 1, ctx->checkpoints->frames.size, f);
+    close_output_file(f, filename);
+}
 
-    Process *p = &processes[idx];
+/**
+ * Release the frames of a checkpoint log
+ */
+void free_checkpoints(CheckpointLog *log) {
+    free(log->frames.data);
+    log->frames.data = NULL;
+    log->frames.size = 0;
+    log->frames.capacity = 0;
+}
 
-    for (int c = 0; c < cpu_count ; c++){
-        int next_remaining = p -> remaining_time;
-        int next_priority = p -> priority;
-        Process *cur = cpus[c].current_process;
-        if (cur == NULL) continue;
-        int cur_remaining = cur -> remaining_time;
-        int cur_priority = cur -> priority;
+/**
+ * Copy the next `bytes` of a checkpoint into `out`; false if the file ends first
+ */
+bool read_checkpoint_bytes(const char **cursor, const char *end, void *out, size_t bytes) {
+    if ((size_t)(end - *cursor) < bytes) return false;
+    if (out) memcpy(out, *cursor, bytes);
+    *cursor += bytes;
+    return true;
+}
 
-        if (cur_remaining < next_remaining || 
-            (cur_remaining == next_remaining && cur_priority > next_priority) ||
-        (cur_remaining == next_remaining && cur_priority == next_priority && cur -> pid < p -> pid)) continue;
-        printf("kicked something out cpu index is: %d time is: %d\n" , c, current_time);
-        printf("incoming to cpu is %d with priority %d\n" , next_remaining , next_priority);
-        cpus[c].current_process = p;
-        p -> state = RUNNING;
-        if (p->start_time == -1) {
-            p->start_time = current_time;
-            p->response_time = current_time - p->arrival_time;
+/**
+ * Earliest time at which two workloads can behave differently
+ *
+ * Walks both in arrival order; the first record that differs (or exists in
+ * only one of them) gives the time. INT_MAX if the workloads are the same.
+ */
+int first_changed_arrival(const Process *old_processes, const int *old_order, int old_count,
+                          const Process *processes, const int *order, int count) {
+    int k = 0;
+    while (k < old_count && k < count) {
+        const Process *a = &old_processes[old_order[k]];
+        const Process *b = &processes[order[k]];
+        if (a->pid != b->pid || a->arrival_time != b->arrival_time || a->burst_time != b->burst_time ||
+            a->priority != b->priority) {
+            return a->arrival_time < b->arrival_time ? a->arrival_time : b->arrival_time;
         }
-        cur -> state = WAITING;
-        enqueue_priority(&FCFSQ , cpus[c].idx, processes);
-        cpus[c].idx = idx;
-        idx = dequeue(&FCFSQ); //this will never return -1
-        p = &processes[idx];
+        k++;
     }
-    enqueue_priority(&FCFSQ , idx , processes);
+    if (k < old_count) return old_processes[old_order[k]].arrival_time;
+    if (k < count) return processes[order[k]].arrival_time;
+    return INT_MAX;
 }
 
 /**
- * Assign processes to idle CPUs based on the current scheduling algorithm
+ * Continue an initialized context from the latest usable checkpoint in `filename` (--resume)
+ *
+ * A checkpoint at time T is usable when every job that arrives before T is
+ * the same in both workloads: the schedule up to T never depends on later
+ * arrivals. Unchanged jobs are matched in arrival order, so they may move
+ * within the file as long as their relative order stays the same. Returns
+ * the time resumed at, or 0 if the run has to start from scratch.
  */
-void assign_processes_to_idle_cpus(Process *processes, int process_count, CPU *cpus, int cpu_count,
-                                Algorithm algorithm, ReadyQueue *ready_queue, int current_time) {
-    // TODO: Select and assign processes to idle CPUs according to the chosen algorithm
+int resume_simulation(SimulationContext *ctx, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening checkpoint file");
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "Error: cannot map checkpoint file %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    const char *cursor = (const char *)mapped;
+    const char *end = cursor + st.st_size;
+
+    CheckpointHeader header;
+    if (!read_checkpoint_bytes(&cursor, end, &header, sizeof(header)) ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, BINARY_MAGIC_LENGTH) != 0 ||
+        header.process_size != sizeof(Process) || header.entry_size != sizeof(QueueEntry) ||
+        header.process_count < 0 || header.checkpoint_count < 0) {
+        fprintf(stderr, "Error: %s is not a checkpoint file written by this build\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    QueuePlacement placement = ctx->runqueues ? ctx->runqueues->placement : PLACE_GLOBAL;
+    if (header.algorithm != (int32_t)ctx->algorithm || header.cpu_count != ctx->cpu_count ||
+        (algorithm_uses_quantum(ctx->algorithm) && header.time_quantum != ctx->time_quantum) ||
+        header.aging != ctx->aging_period || header.placement != (int32_t)placement ||
+        header.switch_cost != ctx->switch_cost || header.migration_cost != ctx->migration_cost ||
+        header.affinity != ctx->affinity_wait) {
+        fprintf(stderr, "Error: %s was written by a %s run on %d CPU(s) (quantum %d, aging %d, --runqueues %s, "
+                        "switch cost %d, migration cost %d, affinity %d); resume with the same options\n",
+                filename, algorithm_code((Algorithm)header.algorithm), header.cpu_count, header.time_quantum,
+                header.aging, placement_name((QueuePlacement)header.placement), header.switch_cost,
+                header.migration_cost, header.affinity);
+        exit(EXIT_FAILURE);
+    }
 
-    (void) process_count;
-    (void) algorithm;
-    (void) ready_queue;
-    // Each algorithm has different process selection criteria
-    // Be careful not to assign the same process to multiple CPUs
+    int old_count = header.process_count;
+    Process *old_processes = (Process *)malloc((old_count ? old_count : 1) * sizeof(Process));
+    int *map = (int *)malloc((old_count ? old_count : 1) * sizeof(int));
+    if (!old_processes || !map) {
+        perror("Failed to allocate checkpoint state");
+        exit(EXIT_FAILURE);
+    }
+    const char *segments = cursor + old_count * sizeof(Process);
+    bool ok = read_checkpoint_bytes(&cursor, end, old_processes, old_count * sizeof(Process)) &&
+              header.segment_count <= (uint64_t)(end - cursor) / sizeof(ResultsSegmentRecord) &&
+              read_checkpoint_bytes(&cursor, end, NULL, header.segment_count * sizeof(ResultsSegmentRecord));
+
+    // Latest frame no later than the first change
+    int *old_order = build_arrival_order(old_processes, old_count, ctx->arena);
+    int changed_at = first_changed_arrival(old_processes, old_order, old_count,
+                                           ctx->processes, ctx->arrival_order, ctx->process_count);
+    const char *frame_start = NULL;
+    CheckpointFrame frame;
+    memset(&frame, 0, sizeof(frame)); // Only read once frame_start is set
+    for (int n = 0; ok && n < header.checkpoint_count; n++) {
+        CheckpointFrame candidate;
+        const char *here = cursor;
+        ok = read_checkpoint_bytes(&cursor, end, &candidate, sizeof(candidate)) &&
+             candidate.bytes >= sizeof(candidate) && candidate.bytes - sizeof(candidate) <= (uint64_t)(end - cursor);
+        if (!ok || candidate.time > changed_at || candidate.time > ctx->max_time) break;
+        frame_start = here;
+        frame = candidate;
+        cursor = here + candidate.bytes;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: checkpoint file %s is truncated\n", filename);
+        exit(EXIT_FAILURE);
+    }
 
-    for (int c = 0; c < cpu_count; c++) {
-        if (cpus[c].current_process != NULL) continue; //if null, don't skip
+    int resumed_at = 0;
+    if (frame_start && ctx->timeline.storage != TIMELINE_NONE && !header.has_timeline) {
+        fprintf(stderr, "Warning: %s holds no timeline (written with --timeline none); "
+                        "simulating from time 0\n", filename);
+        frame_start = NULL;
+    }
 
-        int idx = dequeue(&FCFSQ);
+    // Processes that arrived before the frame, matched by arrival order; their file order must agree
+    int arrived = 0;
+    if (frame_start) {
+        for (int i = 0; i < old_count; i++) map[i] = -1;
+        while (arrived < old_count && old_processes[old_order[arrived]].arrival_time < frame.time) {
+            map[old_order[arrived]] = ctx->arrival_order[arrived];
+            arrived++;
+        }
+        int last = -1;
+        for (int i = 0; i < old_count; i++) {
+            if (map[i] == -1) continue;
+            if (map[i] < last) {
+                fprintf(stderr, "Warning: jobs that arrive before the checkpoint changed order in the file; "
+                                "simulating from time 0\n");
+                frame_start = NULL;
+                break;
+            }
+            last = map[i];
+        }
+    }
 
-        if (idx == -1) break;
+    if (frame_start) {
+        cursor = frame_start + sizeof(CheckpointFrame);
+        const char *frame_end = frame_start + frame.bytes;
+
+        // Final states first, then the live processes as they were at the checkpoint
+        for (int k = 0; k < arrived; k++) ctx->processes[map[old_order[k]]] = old_processes[old_order[k]];
+        for (int n = 0; ok && n < frame.live_count; n++) {
+            CheckpointProcess live;
+            ok = read_checkpoint_bytes(&cursor, frame_end, &live, sizeof(live)) &&
+                 live.process_idx >= 0 && live.process_idx < old_count && map[live.process_idx] != -1;
+            if (ok) ctx->processes[map[live.process_idx]] = live.state;
+        }
 
-        Process *p = &processes[idx];
+        for (int c = 0; ok && c < ctx->cpu_count; c++) {
+            CheckpointCpu saved;
+            ok = read_checkpoint_bytes(&cursor, frame_end, &saved, sizeof(saved)) &&
+                 saved.process_idx < old_count && saved.last_idx < old_count;
+            if (!ok) break;
+            CPU *cpu = &ctx->cpus[c];
+            cpu->current_process = saved.process_idx >= 0 ? &ctx->processes[map[saved.process_idx]] : NULL;
+            cpu->idx = saved.last_idx >= 0 ? map[saved.last_idx] : saved.last_idx;
+            cpu->idle_time = saved.idle_time;
+            cpu->busy_time = saved.busy_time;
+            cpu->last_pid = saved.last_pid;
+            cpu->overhead_left = saved.overhead_left;
+            cpu->overhead_time = saved.overhead_time;
+            cpu->same_cpu_dispatches = saved.same_cpu_dispatches;
+            cpu->migrated_dispatches = saved.migrated_dispatches;
+        }
 
-        if (p->state == COMPLETED || p->arrival_time > current_time) {
-            c--;
-            continue;
+        ok = ok && frame.queue_count == context_queue_count(ctx);
+        for (int k = 0; ok && k < frame.queue_count; k++) {
+            ReadyQueue *q = context_queue(ctx, k);
+            CheckpointQueue saved;
+            ok = read_checkpoint_bytes(&cursor, frame_end, &saved, sizeof(saved)) && saved.size >= 0 &&
+                 (uint64_t)saved.size <= (uint64_t)(frame_end - cursor) / sizeof(QueueEntry) &&
+                 (!saved.ordered || (saved.order >= 0 && saved.order < ORDER_COUNT));
+            if (!ok) break;
+            while (q->capacity < saved.size) grow_queue(q);
+            read_checkpoint_bytes(&cursor, frame_end, q->entries, saved.size * sizeof(QueueEntry));
+            q->size = saved.size;
+            q->front = 0;
+            q->rear = saved.size - 1;
+            q->ordered = false;
+            if (saved.ordered) queue_set_order(q, (QueueOrder)saved.order, ctx->processes);
+            q->next_seq = (unsigned long)saved.next_seq;
+            for (int e = 0; ok && e < q->size; e++) {
+                int idx = q->entries[e].process_idx;
+                ok = idx >= 0 && idx < old_count && map[idx] != -1;
+                if (!ok) break;
+                q->entries[e].process_idx = map[idx];
+                if (q->positions) q->positions[map[idx]] = e;
+            }
+        }
+        if (ok && ctx->mlfq) {
+            ctx->mlfq->nonempty = 0;
+            for (int k = 0; k < MLFQ_LEVELS; k++) {
+                if (ctx->mlfq->levels[k].size > 0) ctx->mlfq->nonempty |= 1u << k;
+            }
         }
 
-        cpus[c].current_process = p;
-        cpus[c].idx = idx;
-        p->state = RUNNING;
+        if (ok && ctx->runqueues) {
+            RunQueues *rq = ctx->runqueues;
+            int64_t next_cpu = 0;
+            ok = read_checkpoint_bytes(&cursor, frame_end, &next_cpu, sizeof(next_cpu));
+            rq->next_cpu = (int)next_cpu;
+            for (int c = 0; ok && c < rq->count; c++) {
+                CheckpointRunQueue saved;
+                ok = read_checkpoint_bytes(&cursor, frame_end, &saved, sizeof(saved));
+                rq->steals[c] = (unsigned long)saved.steals;
+                rq->length_time[c] = saved.length_time;
+                rq->max_length[c] = saved.max_length;
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: checkpoint file %s is corrupt\n", filename);
+            exit(EXIT_FAILURE);
+        }
 
-        if (p->start_time == -1) {
-            p->start_time = current_time;
-            p->response_time = current_time - p->arrival_time;
+        // The schedule so far, clipped to the checkpoint; the timeline is grown like the run grew it
+        const ResultsSegmentRecord *runs = (const ResultsSegmentRecord *)segments;
+        for (uint64_t k = 0; k < header.segment_count; k++) {
+            ResultsSegmentRecord r;
+            memcpy(&r, &runs[k], sizeof(r));
+            int cpu = (int32_t)le32((uint32_t)r.cpu);
+            int start = (int32_t)le32((uint32_t)r.start);
+            int stop = (int32_t)le32((uint32_t)r.end);
+            if (stop > frame.time) stop = frame.time;
+            if (cpu < 0 || cpu >= ctx->cpu_count || start < 0 || start >= stop) continue;
+            timeline_record(&ctx->timeline, cpu, (int32_t)le32((uint32_t)r.pid), start, stop);
+        }
+        while (frame.time > ctx->timeline.capacity) expand_timeline(&ctx->timeline, ctx->timeline.capacity * 2);
+
+        ctx->current_time = frame.time;
+        ctx->completed_count = frame.completed_count;
+        ctx->arrival_cursor = arrived;
+        resumed_at = frame.time;
+    }
+
+    free(old_processes);
+    free(map);
+    munmap(mapped, (size_t)st.st_size);
+    return resumed_at;
+}
+
+/************************* STREAMING INPUT *************************/
+
+/**
+ * Open a workload for incremental reading ("-" means standard input)
+ */
+void open_stream(StreamSource *stream, const char *filename) {
+    if (strcmp(filename, "-") == 0) {
+        stream->fd = STDIN_FILENO;
+    } else {
+        stream->fd = open(filename, O_RDONLY);
+        if (stream->fd < 0) {
+            perror("Error opening process file");
+            exit(EXIT_FAILURE);
+        }
+    }
+    stream->name = filename;
+    stream->capacity = STREAM_BLOCK_SIZE;
+    stream->buffer = (char *)malloc(stream->capacity);
+    if (!stream->buffer) {
+        perror("Failed to allocate stream buffer");
+        exit(EXIT_FAILURE);
+    }
+    stream->start = 0;
+    stream->end = 0;
+    stream->eof = false;
+    stream->has_pending = false;
+    stream->last_arrival = 0;
+    stream->line_number = 0;
+    stream->binary = false;
+    stream->record_size = 0;
+
+    // A binary workload is recognized by its header, then read record by record
+    if (stream_fill(stream, BINARY_MAGIC_LENGTH) &&
+        is_binary_workload(stream->buffer + stream->start, stream->end - stream->start)) {
+        size_t record_size = 0;
+        if (stream_fill(stream, sizeof(WorkloadHeader))) {
+            record_size = le32(((const WorkloadHeader *)(stream->buffer + stream->start))->record_size);
+        }
+        if (record_size < sizeof(WorkloadRecord) || record_size % sizeof(int32_t) != 0) {
+            fprintf(stderr, "Error: %s is not a valid binary workload (truncated or bad header)\n", filename);
+            exit(EXIT_FAILURE);
+        }
+        stream->binary = true;
+        stream->record_size = record_size;
+        stream->start += sizeof(WorkloadHeader);
+    }
+}
+
+/**
+ * Close a stream opened with open_stream()
+ */
+void close_stream(StreamSource *stream) {
+    if (stream->fd != STDIN_FILENO) close(stream->fd);
+    free(stream->buffer);
+    stream->buffer = NULL;
+}
+
+/**
+ * Keep the unconsumed bytes and read one more block after them; false at end of input
+ */
+bool stream_refill(StreamSource *stream) {
+    // Keep the partial record, then make room for more input
+    memmove(stream->buffer, stream->buffer + stream->start, stream->end - stream->start);
+    stream->end -= stream->start;
+    stream->start = 0;
+    if (stream->end == stream->capacity) {
+        char *temp = (char *)realloc(stream->buffer, stream->capacity * 2);
+        if (!temp) {
+            perror("Failed to expand stream buffer");
+            exit(EXIT_FAILURE);
         }
+        stream->buffer = temp;
+        stream->capacity *= 2;
+    }
 
-        p->quantum_used = 0;
+    ssize_t n = read(stream->fd, stream->buffer + stream->end, stream->capacity - stream->end);
+    if (n < 0) {
+        perror("Error reading process stream");
+        exit(EXIT_FAILURE);
     }
+    if (n == 0) stream->eof = true;
+    stream->end += (size_t)n;
+    return n > 0;
+}
 
+/**
+ * Make at least `bytes` unconsumed bytes available; false if the input ends first
+ */
+bool stream_fill(StreamSource *stream, size_t bytes) {
+    while (stream->end - stream->start < bytes) {
+        if (stream->eof || !stream_refill(stream)) return false;
+    }
+    return true;
 }
 
 /**
- * Update waiting times for all waiting processes
+ * Read the next complete line into [*line, *line_end); false at end of input
+ *
+ * The line stays valid until the next call. A final line without a newline
+ * is still returned.
  */
-void update_waiting_times(Process *processes, int process_count, int current_time) {
-    // TODO: Increment waiting_time for processes that have arrived but are not running
-    for (int w = 0 ; w < process_count; w++) {
-        if (processes[w].state == WAITING && processes[w].arrival_time <= current_time) {
-            processes[w].waiting_time++;
+bool stream_read_line(StreamSource *stream, const char **line, const char **line_end) {
+    while (true) {
+        char *eol = memchr(stream->buffer + stream->start, '\n', stream->end - stream->start);
+        if (eol || (stream->eof && stream->start < stream->end)) {
+            *line = stream->buffer + stream->start;
+            *line_end = eol ? eol : stream->buffer + stream->end;
+            stream->start = eol ? (size_t)(eol - stream->buffer) + 1 : stream->end;
+            stream->line_number++;
+            return true;
         }
+        if (stream->eof) return false;
+        stream_refill(stream);
     }
 }
 
 /**
- * Execute processes on CPUs for the current time step
+ * Look at the next process record without consuming it; false once drained
+ *
+ * Stream mode admits jobs as the clock reaches them, so arrival times must be
+ * non-negative and non-decreasing; anything else is a fatal input error.
  */
-void execute_processes(Process *processes, int process_count, CPU *cpus, int cpu_count,
-                     int current_time, int *completed_count) {
-    // TODO: Execute one time unit of each running process and track CPU idle/busy time
-    for (int c = 0 ; c < cpu_count ; c++){ 
-    // check each CPU. If something is mounted, do work (increase busy time, decrease remaining time)
-    //if nothing is running increase idle time. Throw away tasks that finished.
-        if (cpus[c].current_process != NULL) {
-            Process *p = cpus[c].current_process;
-            p->remaining_time--;
-            cpus[c].busy_time++;
-            p->quantum_used++;
-
-            if (p->remaining_time <= 0) {
-                p->finish_time = current_time + 1; // +1 because time is incremented after execution
-                p->state = COMPLETED;
-                cpus[c].current_process = NULL;
-                (*completed_count)++;
+bool stream_peek(StreamSource *stream, int fields[4]) {
+    if (!stream->has_pending) {
+        if (stream->binary) {
+            if (!stream_fill(stream, stream->record_size)) {
+                if (stream->start < stream->end) {
+                    fprintf(stderr, "Error: %s ends in a partial binary record\n", stream->name);
+                    exit(EXIT_FAILURE);
+                }
+                return false;
             }
+            decode_workload_record(stream->buffer + stream->start, stream->pending);
+            stream->start += stream->record_size;
+            stream->line_number++;
         } else {
-            cpus[c].idle_time++;
+            const char *line, *line_end;
+            int items = 0;
+            while (items < 3) {
+                if (!stream_read_line(stream, &line, &line_end)) return false;
+                items = parse_process_line(line, line_end, stream->pending);
+            }
+            if (items == 3) stream->pending[3] = 0; // Default priority
+        }
+
+        if (stream->pending[1] < stream->last_arrival) {
+            fprintf(stderr, "Error: %s %s %ld: arrival time %d is before %d; "
+                            "stream input needs non-decreasing, non-negative arrivals\n",
+                    stream->name, stream->binary ? "record" : "line", stream->line_number,
+                    stream->pending[1], stream->last_arrival);
+            exit(EXIT_FAILURE);
         }
+        stream->last_arrival = stream->pending[1];
+        stream->has_pending = true;
     }
-    (void)processes;
-    (void)process_count;
+    memcpy(fields, stream->pending, sizeof(stream->pending));
+    return true;
 }
 
-/************************* MAIN SIMULATION *************************/
+/**
+ * Take a slot in the process pool, growing the pool if none are free
+ *
+ * Growing moves the pool, so CPU and ready queue pointers into it are
+ * re-pointed afterwards.
+ */
+int alloc_process_slot(SimulationContext *ctx) {
+    if (ctx->free_slots.count > 0) return ctx->free_slots.values[--ctx->free_slots.count];
+
+    if (ctx->process_count >= ctx->process_capacity) {
+        int old_capacity = ctx->process_capacity;
+        int new_capacity = old_capacity * 2;
+        Process *temp = (Process *)realloc(ctx->processes, new_capacity * sizeof(Process));
+        if (!temp) {
+            perror("Failed to expand process pool");
+            exit(EXIT_FAILURE);
+        }
+        ctx->processes = temp;
+        ctx->process_capacity = new_capacity;
+        ctx->ready_queue.processes = temp;
+        if (ctx->ready_queue.positions) {
+            ctx->ready_queue.positions = (int *)arena_grow(ctx->arena, ctx->ready_queue.positions,
+                                                           old_capacity * sizeof(int), new_capacity * sizeof(int));
+            for (int i = old_capacity; i < new_capacity; i++) ctx->ready_queue.positions[i] = -1;
+        }
+        for (int c = 0; ctx->runqueues && c < ctx->runqueues->count; c++) ctx->runqueues->queues[c].processes = temp;
+        for (int c = 0; c < ctx->cpu_count; c++) {
+            if (ctx->cpus[c].current_process != NULL) ctx->cpus[c].current_process = &temp[ctx->cpus[c].idx];
+        }
+    }
+    return ctx->process_count++;
+}
 
 /**
- * Run the entire CPU scheduling simulation
+ * Report a completed stream process and hand its slot back to the pool
  */
-void simulate(Process *processes, int process_count, int cpu_count, Algorithm algorithm, int time_quantum) {
-    // Initialize simulation components
-    ReadyQueue ready_queue_rr; 
-    init_queue(&ready_queue_rr);
+void retire_stream_process(SimulationContext *ctx, int slot) {
+    const Process *p = &ctx->processes[slot];
+    ProcessResult r;
+    r.pid = p->pid;
+    r.arrival_time = p->arrival_time;
+    r.burst_time = p->burst_time;
+    r.priority = p->priority;
+    r.start_time = p->start_time;
+    r.finish_time = p->finish_time;
+    r.response_time = p->response_time;
+    r.completed = true;
+    r.turnaround_time = p->finish_time - p->arrival_time;
+    r.waiting_time = p->waiting_time;
+
+    ctx->stream_turnaround += r.turnaround_time;
+    ctx->stream_waiting += r.waiting_time;
+    ctx->stream_response += r.response_time;
+
+    if (ctx->stream_output & OUTPUT_CSV) print_csv_process_row(&r);
+    int_list_push(&ctx->free_slots, slot);
+}
 
-    CPU *cpus = (CPU *)calloc(cpu_count, sizeof(CPU)); 
-    if (!cpus) {
-        perror("Failed to allocate CPUs");
+/**
+ * Set up a context that admits processes from a stream as they arrive
+ *
+ * Memory follows the number of live processes: completed slots are reused and
+ * no timeline is kept.
+ */
+void init_stream_simulation(SimulationContext *ctx, StreamSource *stream, int cpu_count, Algorithm algorithm,
+                            int time_quantum, SimMode mode, unsigned output, Arena *arena) {
+    Process *pool = (Process *)malloc(STREAM_INITIAL_SLOTS * sizeof(Process));
+    if (!pool) {
+        perror("Failed to allocate process pool");
         exit(EXIT_FAILURE);
     }
-    for (int i = 0; i < cpu_count; i++) cpus[i].id = i;
 
-    int timeline_capacity = INITIAL_TIMELINE_CAPACITY;
-    int **timeline = NULL;
-    init_timeline(&timeline, timeline_capacity, cpu_count);
-
-    int current_time = 0;
-    int completed_count = 0;
-    
-    // Display simulation header
-    printf("\nStarting simulation with %s on %d CPU(s)%s\n", 
-           algorithm_name(algorithm),
-           cpu_count, 
-           algorithm == RR ? ", Quantum=" : "");
-    if (algorithm == RR) printf("%d", time_quantum);
-    printf("\n");
-    int bruh = 0;
-    // Main Simulation Loop
-    while (completed_count < process_count) {
-        // TODO: Complete the simulation loop
-        // The framework is provided, but several function calls need implementation
+    // Start from an empty workload; slots and the ready queue grow as records are admitted
+    init_simulation(ctx, pool, 0, cpu_count, algorithm, time_quantum, mode, TIMELINE_NONE, arena);
 
-        // Handle new process arrivals
-        int arrived_indices[MAX_PROCESSES];
-        int arrival_count = 0;
-        handle_arrivals(processes, process_count, current_time, algorithm, arrived_indices, &arrival_count);
-        //printf("OOOGAGAA");
-        //printf("current arrivals: %d\n", arrival_count);
-        //printf("current time: %d\n", current_time);
-
-        // Enqueue newly arrived processes for Round Robin
-        if (algorithm == RR) {
-            for (int i = 0; i < arrival_count; i++) {
-                enqueue(&FCFSQ, arrived_indices[i]);
-                // enqueue_priority3(&FCFSQ, arrived_indices[i], processes);
-            }
-            handle_rr_quantum_expiry(processes, cpus, cpu_count, time_quantum, &ready_queue_rr, current_time);
-        }
+    ctx->stream = stream;
+    ctx->process_capacity = STREAM_INITIAL_SLOTS;
+    ctx->stream_output = output;
+}
 
+/**
+ * Run a whole simulation fed from a stream, printing rows as jobs complete
+ *
+ * Per-process CSV rows come out in completion order. Only CPU and average
+ * statistics are reported at the end, because finished jobs are not kept.
+ */
+void run_stream(const Options *opts) {
+    StreamSource stream;
+    open_stream(&stream, opts->input_file);
 
+    int fields[4];
+    if (!stream_peek(&stream, fields)) {
+        printf("Warning: No valid processes found in %s\n", opts->input_file);
+        printf("No processes loaded or simulation not possible.\n");
+        close_stream(&stream);
+        return;
+    }
 
-        // Assign processes to idle CPUs
-        assign_processes_to_idle_cpus(processes, process_count, cpus, cpu_count, algorithm,
-                                   &ready_queue_rr, current_time);
-        
-                                           // Handle SRTF preemption
-        if (algorithm == SRTF) {
-            handle_srtf_preemption(processes, process_count, cpus, cpu_count, current_time);
-        }
-        
-        //printf("cpu is currently doing: %d ", cpus[0].current_process);
+    Algorithm algorithm = (Algorithm)opts->algorithms.values[0];
+    int cpu_count = opts->cpu_counts.values[0];
+    int time_quantum = opts->quanta.values[0];
+    unsigned output = opts->output;
+
+    Arena arena;
+    init_arena(&arena);
+    SimulationContext ctx;
+    init_stream_simulation(&ctx, &stream, cpu_count, algorithm, time_quantum, opts->mode, output, &arena);
+    init_aging(&ctx, opts->aging);
+    init_overhead(&ctx, opts->switch_cost, opts->migration_cost);
+    init_affinity(&ctx, opts->affinity);
+    init_horizon(&ctx, opts->max_time);
+    ctx.trace = opts->trace;
+
+    SimStats stats;
+    if (opts->stats) {
+        init_stats(&stats, cpu_count);
+        attach_stats(&ctx, &stats);
+    }
+    LatencyMetrics latency;
+    if (opts->percentiles) {
+        init_latency(&latency);
+        ctx.latency = &latency;
+    }
+    if (opts->placement != PLACE_GLOBAL) init_runqueues(&ctx, opts->placement);
+    init_parallel(&ctx, opts->threads);
+
+    if (output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) {
+        printf("\nStreaming simulation with %s on %d CPU(s)%s", 
+               algorithm_name(algorithm), cpu_count, algorithm_uses_quantum(algorithm) ? ", Quantum=" : "");
+        if (algorithm_uses_quantum(algorithm)) printf("%d", time_quantum);
+        printf("\n(per-process statistics appear in the CSV only; no timeline is kept)\n");
+    }
+    if (output & OUTPUT_CSV) {
+        printf("\n\n--- CSV Output ---\n");
+        print_csv_process_header();
+    }
 
-        // Update timeline
-        if (current_time >= timeline_capacity) {
-            expand_timeline(&timeline, &timeline_capacity, timeline_capacity * 2, cpu_count);
+    run_simulation(&ctx);
+
+    // Jobs still live when the run stopped, then records never admitted, are reported as unfinished
+    if (output & OUTPUT_CSV) {
+        ProcessResult r;
+        memset(&r, 0, sizeof(r));
+        for (int i = 0; i < ctx.process_count; i++) {
+            if (ctx.processes[i].state == COMPLETED) continue;
+            r.pid = ctx.processes[i].pid;
+            r.arrival_time = ctx.processes[i].arrival_time;
+            r.burst_time = ctx.processes[i].burst_time;
+            r.priority = ctx.processes[i].priority;
+            print_csv_process_row(&r);
         }
-        for (int c = 0; c < cpu_count; c++) {
-            timeline[current_time][c] = (cpus[c].current_process != NULL) ? cpus[c].current_process->pid : -1;
+        while (stream_peek(&stream, fields)) {
+            stream.has_pending = false;
+            r.pid = fields[0];
+            r.arrival_time = fields[1];
+            r.burst_time = fields[2];
+            r.priority = fields[3];
+            print_csv_process_row(&r);
         }
+    }
 
-        // Update waiting times for processes
-        update_waiting_times(processes, process_count, current_time); // I think I finished this
+    SimulationResults results;
+    compute_results(ctx.processes, 0, ctx.cpus, ctx.cpu_count, ctx.total_time, &results);
+    results.completed_count = ctx.completed_count;
+    results.stats = ctx.stats;
+    results.latency = ctx.latency;
+    results.runqueues = ctx.runqueues;
+    results.locality = opts->affinity >= 0 || opts->migration_cost > 0;
+    if (ctx.completed_count > 0) {
+        results.avg_turnaround = ctx.stream_turnaround / ctx.completed_count;
+        results.avg_waiting = ctx.stream_waiting / ctx.completed_count;
+        results.avg_response = ctx.stream_response / ctx.completed_count;
+    }
 
-        // Execute processes on CPUs
-        execute_processes(processes, process_count, cpus, cpu_count, current_time, &completed_count);
-        // I think this is also done
+    if (output & OUTPUT_SUMMARY) {
+        printf("\n--- Simulation Results ---\n");
+        print_cpu_stats(&results);
+        print_average_stats(&results);
+        if (ctx.latency) print_latency(ctx.latency);
+        if (ctx.stats) print_sim_stats(ctx.stats);
+        if (ctx.runqueues) print_runqueue_stats(ctx.runqueues, ctx.total_time);
+    }
+    if (output & OUTPUT_CSV) print_csv_tail(&results);
+    if (opts->stats) free_stats(&stats);
+    if (opts->percentiles) free_latency(&latency);
+
+    free_results(&results);
+    free(ctx.processes);
+    cleanup_simulation(&ctx);
+    free_arena(&arena);
+    close_stream(&stream);
+}
 
-        // Advance time
-        current_time++;
+/************************* PARAMETER SWEEP *************************/
 
-        // Safety break to prevent infinite loops
-        if (current_time > timeline_capacity * 5 && completed_count < process_count) {
-            fprintf(stderr, "Warning: Simulation exceeded maximum expected time. Aborting.\n");
-            break;
-        }
-        bruh ++;
-        if (bruh > 100){
-            break;
-        }
-    }
+/**
+ * Worker thread: take configurations off the pool until none are left
+ *
+ * Each run simulates a private copy of the workload in its own context, so
+ * workers share nothing but the job counter. A worker keeps one arena and
+ * resets it between runs instead of allocating each run from scratch.
+ */
+void *sweep_worker(void *arg) {
+    SweepPool *pool = (SweepPool *)arg;
 
-    int total_time = current_time; // Record total simulation time
-    print_results(processes, process_count, cpus, cpu_count, timeline, total_time);
+    Process *processes = (Process *)malloc((pool->max_process_count + 1) * sizeof(Process));
+    if (!processes) {
+        perror("Failed to allocate sweep workload copy");
+        exit(EXIT_FAILURE);
+    }
+    Arena arena;
+    init_arena(&arena);
+
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        int r = pool->next_run++;
+        pthread_mutex_unlock(&pool->lock);
+        if (r >= pool->run_count) break;
+
+        SweepRun *run = &pool->runs[r];
+        const Workload *workload = &pool->workloads[run->workload];
+        if (workload->process_count == 0) continue; // Row of an empty batch file, left at zero
+        memcpy(processes, workload->processes, workload->process_count * sizeof(Process));
+
+        SimulationContext ctx;
+        init_simulation(&ctx, processes, workload->process_count, run->cpu_count, run->algorithm,
+                        run->time_quantum, pool->mode, TIMELINE_NONE, &arena);
+        init_aging(&ctx, pool->aging);
+        init_overhead(&ctx, pool->switch_cost, pool->migration_cost);
+        init_affinity(&ctx, pool->affinity);
+        init_horizon(&ctx, pool->max_time);
+        if (pool->placement != PLACE_GLOBAL) init_runqueues(&ctx, pool->placement);
+        run_simulation(&ctx);
+
+        SimulationResults results;
+        compute_results(processes, workload->process_count, ctx.cpus, ctx.cpu_count, ctx.total_time, &results);
+        run->completed = results.completed_count;
+        run->total_time = results.total_time;
+        run->avg_turnaround = results.avg_turnaround;
+        run->avg_waiting = results.avg_waiting;
+        run->avg_response = results.avg_response;
+        run->utilization = results.utilization;
+
+        free_results(&results);
+        cleanup_simulation(&ctx);
+        arena_reset(&arena);
+    }
 
-    // Cleanup
-    cleanup_timeline(timeline, timeline_capacity);
-    free(cpus);
+    free_arena(&arena);
+    free(processes);
+    return NULL;
 }
 
-/************************* RESULTS DISPLAY *************************/
-
 /**
- * Print the execution timeline visualization
+ * Run every -a/-c/-q combination over the loaded workloads on a thread pool
+ *
+ * The quantum list only multiplies RR and MLFQ runs. Rows are printed in file
+ * and option order regardless of which worker finished first.
  */
-void print_timeline(int **timeline, int total_time, Process *processes, int process_count, int cpu_count) {
-    printf("\nExecution Timeline:\n");
-    int time_units_per_line = (TIMELINE_WIDTH - 5) / TIME_UNIT_WIDTH;
-    if (time_units_per_line <= 0) time_units_per_line = 1; // Ensure at least 1 unit per line
-    int time_segments = (total_time + time_units_per_line - 1) / time_units_per_line;
+void run_sweep(const Options *opts, const Workload *workloads, int workload_count) {
+    SweepPool pool;
+    pool.workloads = workloads;
+    pool.max_process_count = 0;
+    for (int f = 0; f < workload_count; f++) {
+        if (workloads[f].process_count > pool.max_process_count) pool.max_process_count = workloads[f].process_count;
+    }
+    pool.mode = opts->mode;
+    pool.placement = opts->placement;
+    pool.aging = opts->aging;
+    pool.switch_cost = opts->switch_cost;
+    pool.migration_cost = opts->migration_cost;
+    pool.affinity = opts->affinity;
+    pool.max_time = opts->max_time;
+    pool.next_run = 0;
+    pool.run_count = 0;
+
+    int max_runs = workload_count * opts->algorithms.count * opts->cpu_counts.count * opts->quanta.count;
+    pool.runs = (SweepRun *)calloc(max_runs, sizeof(SweepRun));
+    if (!pool.runs) {
+        perror("Failed to allocate sweep runs");
+        exit(EXIT_FAILURE);
+    }
 
-    // Print color key
-    printf("\nColor Key:\n");
-    for (int i = 0; i < process_count; i++) {
-        printf("%sPID %-2d%s ", get_color_for_pid(processes[i].pid), processes[i].pid, COLOR_RESET);
-        if ((i + 1) % 8 == 0 && i + 1 < process_count) printf("\n");
+    for (int f = 0; f < workload_count; f++) {
+        for (int a = 0; a < opts->algorithms.count; a++) {
+            Algorithm algorithm = (Algorithm)opts->algorithms.values[a];
+            for (int c = 0; c < opts->cpu_counts.count; c++) {
+                int quantum_runs = algorithm_uses_quantum(algorithm) ? opts->quanta.count : 1;
+                for (int q = 0; q < quantum_runs; q++) {
+                    SweepRun *run = &pool.runs[pool.run_count++];
+                    run->workload = f;
+                    run->algorithm = algorithm;
+                    run->cpu_count = opts->cpu_counts.values[c];
+                    run->time_quantum = opts->quanta.values[q];
+                }
+            }
+        }
     }
-    printf("\n");
 
-    // Print timeline in segments
-    for (int segment = 0; segment < time_segments; segment++) {
-        int start_t = segment * time_units_per_line;
-        int end_t = start_t + time_units_per_line;
-        if (end_t > total_time) end_t = total_time;
+    int workers = opts->workers;
+    if (workers <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (int)online : 1;
+    }
+    if (workers > pool.run_count) workers = pool.run_count;
 
-        printf("\nTime %d to %d:\n", start_t, end_t - 1);
+    if ((opts->output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) && opts->batch) {
+        printf("\nSweeping %d run(s) over %d workload(s) on %d worker thread(s)\n", pool.run_count,
+               workload_count, workers);
+    } else if (opts->output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) {
+        printf("\nSweeping %d configuration(s) on %d worker thread(s)\n", pool.run_count, workers);
+    }
 
-        // Time markers
-        printf("Time: ");
-        for (int t = start_t; t < end_t; t++) {
-            printf("%-5d", t); // Print time marker for each unit
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    if (!threads) {
+        perror("Failed to allocate sweep workers");
+        exit(EXIT_FAILURE);
+    }
+    for (int w = 0; w < workers; w++) {
+        if (pthread_create(&threads[w], NULL, sweep_worker, &pool) != 0) {
+            perror("Failed to start sweep worker");
+            exit(EXIT_FAILURE);
         }
-        printf("\n");
+    }
+    for (int w = 0; w < workers; w++) pthread_join(threads[w], NULL);
+    pthread_mutex_destroy(&pool.lock);
 
-        // CPU timelines
-        for (int c = 0; c < cpu_count; c++) {
-            printf("CPU%-2d ", c);
-            for (int t = start_t; t < end_t; t++) {
-                int pid = timeline[t][c];
-                if (pid == -1) {
-                    printf("%-*s", TIME_UNIT_WIDTH, "."); // Idle marker
-                } else {
-                    printf("%s%-*d%s", get_color_for_pid(pid), TIME_UNIT_WIDTH, pid, COLOR_RESET);
-                }
-            }
-            printf("\n");
+    print_sweep_csv(pool.runs, pool.run_count, workloads, opts->batch);
+
+    free(threads);
+    free(pool.runs);
+}
+
+/**
+ * Print the merged sweep table, one row per configuration
+ *
+ * In batch mode every row starts with the file it simulated.
+ */
+void print_sweep_csv(const SweepRun *runs, int run_count, const Workload *workloads, bool batch) {
+    printf("\n--- Sweep CSV Output ---\n");
+    if (batch) printf("File,");
+    printf("Algorithm,CPUs,Quantum,Completed,TotalTime,AvgTurnaround,AvgWaiting,AvgResponse,Utilization%%\n");
+    for (int r = 0; r < run_count; r++) {
+        const SweepRun *run = &runs[r];
+        if (batch) {
+            print_csv_text(workloads[run->workload].file);
+            putchar(',');
+        }
+        printf("%s,%d,", algorithm_code(run->algorithm), run->cpu_count);
+        if (algorithm_uses_quantum(run->algorithm)) printf("%d,", run->time_quantum);
+        else printf("N/A,");
+        if (run->completed > 0) {
+            printf("%d,%d,%.2f,%.2f,%.2f,%.2f\n", run->completed, run->total_time,
+                   run->avg_turnaround, run->avg_waiting, run->avg_response, run->utilization);
+        } else {
+            printf("%d,%d,N/A,N/A,N/A,%.2f\n", run->completed, run->total_time, run->utilization);
         }
     }
+    printf("--- End Sweep CSV Output ---\n");
 }
 
 /**
- * Print detailed process statistics
+ * Print a CSV field, quoted if it contains a comma, quote or line break
  */
-void print_process_stats(Process *processes, int process_count) {
-    printf("\nProcess Statistics:\n");
-    printf("%-6s %-7s %-7s %-7s %-7s %-7s %-7s %-7s\n",
-           "PID", "Arrival", "Burst", "Start", "Finish", "Turn.", "Waiting", "Resp.");
-    printf("----------------------------------------------------------------\n");
+void print_csv_text(const char *text) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        fputs(text, stdout);
+        return;
+    }
+    putchar('"');
+    for (const char *c = text; *c; c++) {
+        if (*c == '"') putchar('"');
+        putchar(*c);
+    }
+    putchar('"');
+}
 
-    for (int i = 0; i < process_count; i++) {
-        Process *p = &processes[i];
-        if (p->finish_time != -1) { // Only calculate for completed processes
-            int turnaround = p->finish_time - p->arrival_time;
-            int waiting = turnaround - p->burst_time;
-            if (waiting < 0) waiting = 0; // Cannot be negative
+/************************* BATCH MODE *************************/
 
-            printf("%-6d %-7d %-7d %-7d %-7d %-7d %-7d %-7d\n",
-                   p->pid, p->arrival_time, p->burst_time,
-                   p->start_time, p->finish_time, turnaround, waiting, p->response_time);
-        } else {
-            printf("%-6d %-7d %-7d %-7s %-7s %-7s %-7s %-7s\n",
-                   p->pid, p->arrival_time, p->burst_time,
-                   (p->start_time == -1 ? "N/A" : "-"), "N/A", "N/A", "N/A",
-                   (p->response_time == -1 ? "N/A" : "-"));
+/**
+ * Add a -f argument to the batch: a file as is, a directory as its files
+ *
+ * A directory contributes every regular file not starting with '.', sorted
+ * by name, without descending into subdirectories. The list owns its strings.
+ */
+void expand_input_path(const char *path, StringList *files) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        char *copy = strdup(path);
+        if (!copy) {
+            perror("Failed to allocate file name");
+            exit(EXIT_FAILURE);
         }
+        string_list_push(files, copy);
+        return;
     }
-    printf("----------------------------------------------------------------\n");
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "Error opening workload directory %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    size_t path_len = strlen(path);
+    bool slash = path_len > 0 && path[path_len - 1] == '/';
+    int first = files->count;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        size_t len = path_len + 1 + strlen(entry->d_name) + 1;
+        char *name = (char *)malloc(len);
+        if (!name) {
+            perror("Failed to allocate file name");
+            exit(EXIT_FAILURE);
+        }
+        snprintf(name, len, slash ? "%s%s" : "%s/%s", path, entry->d_name);
+        if (stat(name, &st) != 0 || !S_ISREG(st.st_mode)) {
+            free(name);
+            continue;
+        }
+        string_list_push(files, name);
+    }
+    closedir(dir);
+    qsort(files->values + first, files->count - first, sizeof(char *), compare_strings);
 }
 
 /**
- * Print CPU usage statistics
+ * Order two file names for qsort()
  */
-void print_cpu_stats(CPU *cpus, int cpu_count) {
-    printf("\nCPU Statistics:\n");
-    printf("%-6s %-9s %-9s %-12s\n", "CPU ID", "Busy Time", "Idle Time", "Utilization");
-    printf("------------------------------------------\n");
-    for (int i = 0; i < cpu_count; i++) {
-        double utilization = 0.0;
-        int cpu_total_time = cpus[i].busy_time + cpus[i].idle_time;
-        if (cpu_total_time > 0) {
-            utilization = 100.0 * cpus[i].busy_time / cpu_total_time;
+int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * Loader thread: read files off the batch until none are left
+ */
+void *batch_load_worker(void *arg) {
+    BatchLoader *loader = (BatchLoader *)arg;
+
+    while (true) {
+        pthread_mutex_lock(&loader->lock);
+        int f = loader->next_file++;
+        pthread_mutex_unlock(&loader->lock);
+        if (f >= loader->workload_count) break;
+
+        Workload *workload = &loader->workloads[f];
+        if (!read_process_file(workload->file, &workload->processes, &workload->process_count)) {
+            fprintf(stderr, "Error opening process file %s: %s\n", workload->file, strerror(errno));
+            exit(EXIT_FAILURE);
         }
-        printf("%-6d %-9d %-9d %-11.2f%%\n", cpus[i].id, cpus[i].busy_time, cpus[i].idle_time, utilization);
     }
-    printf("------------------------------------------\n");
+    return NULL;
 }
 
 /**
- * Print average performance metrics
+ * Expand the -f arguments and load every workload file on a thread pool
+ *
+ * Exits if a file cannot be read. Files without valid records are warned
+ * about and keep their rows in the sweep table, with nothing completed.
  */
-void print_average_stats(Process *processes, int process_count) {
-    double total_turnaround = 0.0, total_waiting = 0.0, total_response = 0.0;
-    int valid_stats_count = 0;
+Workload *load_batch(const Options *opts, int *workload_count) {
+    StringList files = {NULL, 0, 0};
+    for (int i = 0; i < opts->input_files.count; i++) expand_input_path(opts->input_files.values[i], &files);
+    if (files.count == 0) {
+        fprintf(stderr, "Error: no workload files found in %s\n", opts->input_file);
+        exit(EXIT_FAILURE);
+    }
 
-    for (int i = 0; i < process_count; i++) {
-        Process *p = &processes[i];
-        if (p->finish_time != -1) { // Only calculate for completed processes
-            int turnaround = p->finish_time - p->arrival_time;
-            int waiting = turnaround - p->burst_time;
-            if (waiting < 0) waiting = 0;
+    BatchLoader loader;
+    loader.workload_count = files.count;
+    loader.next_file = 0;
+    loader.workloads = (Workload *)calloc(files.count, sizeof(Workload));
+    if (!loader.workloads) {
+        perror("Failed to allocate batch workloads");
+        exit(EXIT_FAILURE);
+    }
+    for (int f = 0; f < files.count; f++) loader.workloads[f].file = files.values[f];
+    free_string_list(&files, false); // The workloads own the names now
 
-            total_turnaround += turnaround;
-            total_waiting += waiting;
-            total_response += p->response_time;
-            valid_stats_count++;
+    int workers = opts->workers;
+    if (workers <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (int)online : 1;
+    }
+    if (workers > loader.workload_count) workers = loader.workload_count;
+
+    pthread_mutex_init(&loader.lock, NULL);
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    if (!threads) {
+        perror("Failed to allocate batch loaders");
+        exit(EXIT_FAILURE);
+    }
+    for (int w = 0; w < workers; w++) {
+        if (pthread_create(&threads[w], NULL, batch_load_worker, &loader) != 0) {
+            perror("Failed to start batch loader");
+            exit(EXIT_FAILURE);
         }
     }
+    for (int w = 0; w < workers; w++) pthread_join(threads[w], NULL);
+    pthread_mutex_destroy(&loader.lock);
+    free(threads);
 
-    if (valid_stats_count > 0) {
-        printf("\nAverage Statistics (for %d completed processes):\n", valid_stats_count);
-        printf("  Average Turnaround Time: %.2f\n", total_turnaround / valid_stats_count);
-        printf("  Average Waiting Time:    %.2f\n", total_waiting / valid_stats_count);
-        printf("  Average Response Time:   %.2f\n", total_response / valid_stats_count);
-    } else {
-        printf("\nNo processes completed. Cannot calculate average statistics.\n");
+    for (int f = 0; f < loader.workload_count; f++) {
+        if (loader.workloads[f].process_count == 0) {
+            printf("Warning: No valid processes found in %s\n", loader.workloads[f].file);
+        }
     }
+    *workload_count = loader.workload_count;
+    return loader.workloads;
 }
 
 /**
- * Generate CSV output for automated testing
+ * Release loaded workloads, and their file names if they own them
  */
-void print_csv_output(Process *processes, int process_count, CPU *cpus, int cpu_count) {
-    printf("\n\n--- CSV Output ---\n");
-    
-    // Process stats CSV
-    printf("\nProcess Stats (CSV):\n");
-    printf("PID,Arrival,Burst,Priority,Start,Finish,Turnaround,Waiting,Response\n");
-    for (int i = 0; i < process_count; i++) {
-        Process *p = &processes[i];
-        if (p->finish_time != -1) {
-            int turnaround = p->finish_time - p->arrival_time;
-            int waiting = turnaround - p->burst_time;
-            if (waiting < 0) waiting = 0;
-            printf("%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
-                   p->pid, p->arrival_time, p->burst_time, p->priority,
-                   p->start_time, p->finish_time, turnaround, waiting, p->response_time);
-        } else {
-             printf("%d,%d,%d,%d,%s,%s,%s,%s,%s\n",
-                   p->pid, p->arrival_time, p->burst_time, p->priority,
-                   "N/A", "N/A", "N/A", "N/A", "N/A");
-        }
+void free_workloads(Workload *workloads, int workload_count, bool owned) {
+    for (int f = 0; f < workload_count; f++) {
+        free(workloads[f].processes);
+        if (owned) free(workloads[f].file);
     }
+    free(workloads);
+}
 
-    // CPU stats CSV
-    printf("\nCPU Stats (CSV):\n");
-    printf("CPU_ID,BusyTime,IdleTime,Utilization%%\n");
-    for (int i = 0; i < cpu_count; i++) {
-        double utilization = 0.0;
-        int cpu_total_time = cpus[i].busy_time + cpus[i].idle_time;
-        if (cpu_total_time > 0) {
-            utilization = 100.0 * cpus[i].busy_time / cpu_total_time;
-        }
-        printf("%d,%d,%d,%.2f\n", cpus[i].id, cpus[i].busy_time, cpus[i].idle_time, utilization);
+/************************* LIBRARY API *************************/
+
+/**
+ * Fill `config` with the CLI defaults
+ */
+void sched_default_config(SchedConfig *config) {
+    config->algorithm = SCHED_ALGO_FCFS;
+    config->cpu_count = 1;
+    config->time_quantum = DEFAULT_TIME_QUANTUM;
+    config->aging = 0;
+}
+
+/**
+ * Copy computed statistics into the library's result layout; false (and `to` empty) if out of memory
+ */
+bool copy_results(const SimulationResults *from, SchedResults *to) {
+    to->process_count = from->process_count;
+    to->cpu_count = from->cpu_count;
+    to->total_time = from->total_time;
+    to->completed_count = from->completed_count;
+    to->avg_turnaround = from->avg_turnaround;
+    to->avg_waiting = from->avg_waiting;
+    to->avg_response = from->avg_response;
+    to->utilization = from->utilization;
+    to->processes = (SchedProcessResult *)malloc((from->process_count ? from->process_count : 1) *
+                                                 sizeof(SchedProcessResult));
+    to->cpus = (SchedCpuResult *)malloc(from->cpu_count * sizeof(SchedCpuResult));
+    if (!to->processes || !to->cpus) {
+        free(to->processes);
+        free(to->cpus);
+        memset(to, 0, sizeof(*to));
+        return false;
     }
 
-    // Average stats CSV
-    double total_turnaround = 0.0, total_waiting = 0.0, total_response = 0.0;
-    int valid_stats_count = 0;
-    for (int i = 0; i < process_count; i++) {
-        Process *p = &processes[i];
-        if (p->finish_time != -1) {
-            int turnaround = p->finish_time - p->arrival_time;
-            int waiting = turnaround - p->burst_time;
-            if (waiting < 0) waiting = 0;
-            
-            total_turnaround += turnaround;
-            total_waiting += waiting;
-            total_response += p->response_time;
-            valid_stats_count++;
-        }
+    for (int i = 0; i < from->process_count; i++) {
+        const ProcessResult *r = &from->processes[i];
+        SchedProcessResult *out = &to->processes[i];
+        out->pid = r->pid;
+        out->arrival_time = r->arrival_time;
+        out->burst_time = r->burst_time;
+        out->priority = r->priority;
+        out->start_time = r->start_time;
+        out->finish_time = r->finish_time;
+        out->turnaround_time = r->turnaround_time;
+        out->waiting_time = r->waiting_time;
+        out->response_time = r->response_time;
+        out->completed = r->completed;
+    }
+    for (int c = 0; c < from->cpu_count; c++) {
+        to->cpus[c].id = from->cpus[c].id;
+        to->cpus[c].busy_time = from->cpus[c].busy_time;
+        to->cpus[c].idle_time = from->cpus[c].idle_time;
+        to->cpus[c].utilization = from->cpus[c].utilization;
     }
+    return true;
+}
 
-    printf("\nAverage Stats (CSV):\n");
-    printf("AvgTurnaround,AvgWaiting,AvgResponse\n");
-    if (valid_stats_count > 0) {
-        printf("%.2f,%.2f,%.2f\n",
-               total_turnaround / valid_stats_count,
-               total_waiting / valid_stats_count,
-               total_response / valid_stats_count);
-    } else {
-        printf("N/A,N/A,N/A\n");
+/**
+ * Simulate one configuration in-process, the same run `-f ... --output csv` prints
+ *
+ * Runs event-driven with no timeline and no event logging, like a sweep run.
+ */
+int sched_run(const SchedJob *jobs, int job_count, const SchedConfig *config, SchedResults *results) {
+    memset(results, 0, sizeof(*results));
+    if (!config || job_count < 0 || (job_count > 0 && !jobs) || config->cpu_count < 1 ||
+        config->algorithm < FCFS || config->algorithm > PPRIO || config->aging < 0 ||
+        (algorithm_uses_quantum((Algorithm)config->algorithm) && config->time_quantum < 1)) {
+        return -1;
     }
-    printf("--- End CSV Output ---\n");
+
+    Process *processes = (Process *)malloc((job_count ? job_count : 1) * sizeof(Process));
+    if (!processes) return -2;
+    for (int i = 0; i < job_count; i++) {
+        init_process(&processes[i], jobs[i].pid, jobs[i].arrival_time, jobs[i].burst_time, jobs[i].priority);
+    }
+
+    Arena arena;
+    init_arena(&arena);
+    SimulationContext ctx;
+    init_simulation(&ctx, processes, job_count, config->cpu_count, (Algorithm)config->algorithm,
+                    config->time_quantum, SIM_EVENT, TIMELINE_NONE, &arena);
+    init_aging(&ctx, config->aging);
+    init_horizon(&ctx, 0);
+    ctx.quiet = true;
+    run_simulation(&ctx);
+
+    SimulationResults computed;
+    compute_results(processes, job_count, ctx.cpus, ctx.cpu_count, ctx.total_time, &computed);
+    bool copied = copy_results(&computed, results);
+    if (copied) results->stopped_early = ctx.stopped_early;
+
+    free_results(&computed);
+    cleanup_simulation(&ctx);
+    free_arena(&arena);
+    free(processes);
+    return copied ? 0 : -2;
 }
 
 /**
- * Display all simulation results
+ * Release the arrays of a results struct filled by sched_run()
  */
-void print_results(Process *processes, int process_count, CPU *cpus, int cpu_count, int **timeline, int total_time) {
-    printf("\n--- Simulation Results ---\n");
+void sched_free_results(SchedResults *results) {
+    free(results->processes);
+    free(results->cpus);
+    results->processes = NULL;
+    results->cpus = NULL;
+    results->process_count = 0;
+    results->cpu_count = 0;
+}
 
-    // Print visual timeline
-    print_timeline(timeline, total_time, processes, process_count, cpu_count);
-    
-    // Print detailed statistics
-    print_process_stats(processes, process_count);
-    print_cpu_stats(cpus, cpu_count);
-    print_average_stats(processes, process_count);
-    
-    // Print CSV output for automated testing
-    print_csv_output(processes, process_count, cpus, cpu_count);
+/**
+ * Load a text or binary workload file into a new job array
+ */
+int sched_load_jobs(const char *filename, SchedJob **jobs, int *job_count) {
+    Process *processes = NULL;
+    int count = 0;
+    *jobs = NULL;
+    *job_count = 0;
+    if (!read_process_file(filename, &processes, &count)) return -1;
+
+    SchedJob *out = (SchedJob *)malloc((count ? count : 1) * sizeof(SchedJob));
+    if (!out) {
+        perror("Memory allocation failed for jobs");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        out[i].pid = processes[i].pid;
+        out[i].arrival_time = processes[i].arrival_time;
+        out[i].burst_time = processes[i].burst_time;
+        out[i].priority = processes[i].priority;
+    }
+    free(processes);
+    *jobs = out;
+    *job_count = count;
+    return 0;
+}
+
+/**
+ * Release a job array from sched_load_jobs()
+ */
+void sched_free_jobs(SchedJob *jobs) {
+    free(jobs);
+}
+
+/**
+ * Look up an algorithm by its CLI name; -1 if unknown
+ */
+int sched_parse_algorithm(const char *name) {
+    Algorithm algorithm;
+    return parse_algorithm_name(name, &algorithm) ? (int)algorithm : -1;
 }
 
 /************************* MAIN FUNCTION *************************/
 
+// The library build (-DSCHEDULER_LIBRARY) leaves out the command-line entry point
+#ifndef SCHEDULER_LIBRARY
+
 int main(int argc, char *argv[]) {
-    init_queue(&FCFSQ);
-    Algorithm algorithm = FCFS;
-    int cpu_count = 1;
-    int time_quantum = DEFAULT_TIME_QUANTUM;
-    char *input_file = NULL;
+    Options opts = {0};
+    opts.mode = SIM_EVENT;
+    opts.storage = TIMELINE_RLE;
+    opts.output = OUTPUT_ALL;
+    opts.checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+    opts.affinity = -1;
+    opts.window.start = 0;
+    opts.window.end = -1;
+    opts.window.bucket = 1;
 
     // Parse command line arguments
-    parse_arguments(argc, argv, &algorithm, &cpu_count, &time_quantum, &input_file);
+    parse_arguments(argc, argv, &opts);
+
+    if (opts.replay_file) {
+        replay_results(opts.replay_file, opts.output, &opts.window);
+        free_int_list(&opts.algorithms);
+        free_int_list(&opts.cpu_counts);
+        free_int_list(&opts.quanta);
+        free_string_list(&opts.input_files, false);
+        return EXIT_SUCCESS;
+    }
+
+    if (opts.stream) {
+        run_stream(&opts);
+        free_int_list(&opts.algorithms);
+        free_int_list(&opts.cpu_counts);
+        free_int_list(&opts.quanta);
+        free_string_list(&opts.input_files, false);
+        return EXIT_SUCCESS;
+    }
+
+    if (opts.batch) {
+        int workload_count = 0;
+        Workload *workloads = load_batch(&opts, &workload_count);
+        if (opts.output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) {
+            long total = 0;
+            for (int f = 0; f < workload_count; f++) total += workloads[f].process_count;
+            printf("Loaded %ld processes from %d workload file(s)\n", total, workload_count);
+        }
+        run_sweep(&opts, workloads, workload_count);
+        free_workloads(workloads, workload_count, true);
+        free_int_list(&opts.algorithms);
+        free_int_list(&opts.cpu_counts);
+        free_int_list(&opts.quanta);
+        free_string_list(&opts.input_files, false);
+        return EXIT_SUCCESS;
+    }
 
     // Load processes
     Process *processes = NULL;
     int process_count = 0;
-    load_processes(input_file, &processes, &process_count);
+    load_processes(opts.input_file, &processes, &process_count);
+    if (opts.binary_out || opts.text_out) {
+        if (opts.binary_out) write_binary_workload(opts.binary_out, processes, process_count);
+        if (opts.text_out) write_text_workload(opts.text_out, processes, process_count);
+        free_int_list(&opts.algorithms);
+        free_int_list(&opts.cpu_counts);
+        free_int_list(&opts.quanta);
+        free_string_list(&opts.input_files, false);
+        free(processes);
+        return EXIT_SUCCESS;
+    }
+    bool banners = (opts.output & (OUTPUT_TIMELINE | OUTPUT_SUMMARY)) != 0;
+    if (process_count > 0 && banners) printf("Loaded %d processes from %s\n", process_count, opts.input_file);
 
     // Run simulation if processes were loaded successfully
-    if (process_count > 0) {
-        simulate(processes, process_count, cpu_count, algorithm, time_quantum);
+    if (process_count > 0 && opts.sweep) {
+        Workload workload = {opts.input_file, processes, process_count};
+        run_sweep(&opts, &workload, 1);
+    } else if (process_count > 0) {
+        simulate(processes, process_count, &opts);
     } else {
         printf("No processes loaded or simulation not possible.\n");
     }
 
     // Clean up
+    free_int_list(&opts.algorithms);
+    free_int_list(&opts.cpu_counts);
+    free_int_list(&opts.quanta);
+    free_string_list(&opts.input_files, false);
     free(processes);
     return EXIT_SUCCESS;
 }
+
+#endif // SCHEDULER_LIBRARY
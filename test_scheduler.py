@@ -17,6 +17,8 @@ The framework tests multiple scheduling algorithms:
 - Shortest Job First (SJF)
 - Shortest Remaining Time First (SRTF)
 - Round-Robin (RR) with configurable quantum
+- Multilevel Feedback Queue (MLFQ)
+- Priority, non-preemptive and preemptive (PRIO, PPRIO)
 
 It also tests various edge cases:
 - Priority inversion scenarios
@@ -25,6 +27,14 @@ It also tests various edge cases:
 - Simultaneous job arrivals
 - Tie-breaking rules
 
+Every case runs once per flag set in CASE_VARIANTS, so the tick-by-tick
+clock (-m tick) and the threaded per-CPU step (-j 3) have to reproduce the
+serial event-driven results exactly. Cases may carry their own flags,
+e.g. --switch-cost or --affinity with hand-derived overhead and
+dispatch-locality figures. Command-line checks then cover behavior outside
+the CSV tables, such as stream input rejecting out-of-order arrivals and
+--resume matching a run from scratch.
+
 Usage:
     python test_scheduler.py [options]
 
@@ -34,6 +44,7 @@ Options:
     --test NAME          Run only the specified test
     --verbose            Show detailed scheduler output
     --no-cleanup         Keep generated test files
+    --library PATH       Run the cases in-process through libscheduler.so
 
 Example:
     # Compile your scheduler
@@ -44,6 +55,7 @@ Example:
 """
 
 import subprocess
+import ctypes
 import csv
 import io
 import os
@@ -56,6 +68,8 @@ from typing import Dict, List, Tuple, Optional, Any, Union
 SCHEDULER_EXECUTABLE = './scheduler'  # Default path to scheduler executable
 FLOAT_TOLERANCE = 0.01  # Tolerance for floating-point comparisons
 DEFAULT_TIMEOUT = 10    # Default timeout in seconds
+# Flag sets every test case is rerun with; each must give the same results
+CASE_VARIANTS: List[List[str]] = [[], ['-m', 'tick'], ['-j', '3']]
 
 # --- ANSI Color Codes ---
 _supports_color = hasattr(sys.stdout, "isatty") and sys.stdout.isatty() and sys.platform != 'win32'
@@ -68,23 +82,28 @@ COLOR_BOLD = "\033[1m" if _supports_color else ""
 COLOR_RESET = "\033[0m" if _supports_color else ""
 
 # --- Types ---
-TestCase = Tuple[str, str, int, int, str, Dict[str, List[Dict[str, str]]]]
+# Name, algorithm, CPUs, quantum, input file, expected results[, extra scheduler flags]
+TestCase = Union[Tuple[str, str, int, int, str, Dict[str, List[Dict[str, str]]]],
+                 Tuple[str, str, int, int, str, Dict[str, List[Dict[str, str]]], List[str]]]
+CheckCase = Tuple[str, str, Any]  # Name, algorithm, check(executable, test_files) -> mismatches
 ResultsDict = Dict[str, List[Dict[str, str]]]
 
 
 # --- Helper Functions ---
 def run_scheduler(executable: str, algorithm: str, cpus: int, quantum: int, 
-                  input_file: str, verbose: bool = False) -> Optional[str]:
+                  input_file: str, verbose: bool = False,
+                  extra_args: Optional[List[str]] = None) -> Optional[str]:
     """
     Run the CPU scheduler executable with the specified parameters.
     
     Args:
         executable: Path to the scheduler executable
-        algorithm: Scheduling algorithm (FCFS, SJF, SRTF, RR)
+        algorithm: Scheduling algorithm (FCFS, SJF, SRTF, RR, MLFQ, PRIO, PPRIO)
         cpus: Number of CPUs
-        quantum: Time quantum for Round Robin (ignored for other algorithms)
+        quantum: Time quantum for Round Robin and the top MLFQ level (ignored for other algorithms)
         input_file: Path to the process input file
         verbose: Whether to print the scheduler's output
+        extra_args: Further command-line flags, e.g. ['-m', 'tick']
         
     Returns:
         The stdout output from the scheduler, or None if execution failed
@@ -95,8 +114,10 @@ def run_scheduler(executable: str, algorithm: str, cpus: int, quantum: int,
         '-a', algorithm,
         '-c', str(cpus)
     ]
-    if algorithm == 'RR':
+    if algorithm in ('RR', 'MLFQ'):
         cmd.extend(['-q', str(quantum)])
+    if extra_args:
+        cmd.extend(extra_args)
 
     try:
         print(f"Running: {' '.join(cmd)}")
@@ -122,6 +143,101 @@ def run_scheduler(executable: str, algorithm: str, cpus: int, quantum: int,
         return None
 
 
+class SchedJob(ctypes.Structure):
+    _fields_ = [('pid', ctypes.c_int), ('arrival_time', ctypes.c_int),
+                ('burst_time', ctypes.c_int), ('priority', ctypes.c_int)]
+
+
+class SchedConfig(ctypes.Structure):
+    _fields_ = [('algorithm', ctypes.c_int), ('cpu_count', ctypes.c_int),
+                ('time_quantum', ctypes.c_int), ('aging', ctypes.c_int)]
+
+
+class SchedProcessResult(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int) for name in
+                ('pid', 'arrival_time', 'burst_time', 'priority', 'start_time', 'finish_time',
+                 'turnaround_time', 'waiting_time', 'response_time', 'completed')]
+
+
+class SchedCpuResult(ctypes.Structure):
+    _fields_ = [('id', ctypes.c_int), ('busy_time', ctypes.c_int),
+                ('idle_time', ctypes.c_int), ('utilization', ctypes.c_double)]
+
+
+class SchedResults(ctypes.Structure):
+    _fields_ = [('processes', ctypes.POINTER(SchedProcessResult)), ('process_count', ctypes.c_int),
+                ('cpus', ctypes.POINTER(SchedCpuResult)), ('cpu_count', ctypes.c_int),
+                ('total_time', ctypes.c_int), ('completed_count', ctypes.c_int),
+                ('avg_turnaround', ctypes.c_double), ('avg_waiting', ctypes.c_double),
+                ('avg_response', ctypes.c_double), ('utilization', ctypes.c_double),
+                ('stopped_early', ctypes.c_int)]
+
+
+def load_library(path: str) -> ctypes.CDLL:
+    """Load libscheduler and declare the scheduler.h signatures."""
+    lib = ctypes.CDLL(os.path.abspath(path))
+    lib.sched_default_config.argtypes = [ctypes.POINTER(SchedConfig)]
+    lib.sched_run.argtypes = [ctypes.POINTER(SchedJob), ctypes.c_int, ctypes.POINTER(SchedConfig),
+                              ctypes.POINTER(SchedResults)]
+    lib.sched_free_results.argtypes = [ctypes.POINTER(SchedResults)]
+    lib.sched_load_jobs.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.POINTER(SchedJob)),
+                                    ctypes.POINTER(ctypes.c_int)]
+    lib.sched_free_jobs.argtypes = [ctypes.POINTER(SchedJob)]
+    lib.sched_parse_algorithm.argtypes = [ctypes.c_char_p]
+    return lib
+
+
+def run_library(lib: ctypes.CDLL, algorithm: str, cpus: int, quantum: int,
+                input_file: str) -> Optional[ResultsDict]:
+    """
+    Run one case in-process through libscheduler instead of the executable.
+
+    Returns the same dictionary parse_all_csv() builds from the CSV output,
+    formatted the way the CSV prints it, or None if the library rejects the run.
+    """
+    jobs = ctypes.POINTER(SchedJob)()
+    job_count = ctypes.c_int()
+    if lib.sched_load_jobs(input_file.encode(), ctypes.byref(jobs), ctypes.byref(job_count)) != 0:
+        print(f"{COLOR_RED}Error: library could not load '{input_file}'{COLOR_RESET}")
+        return None
+
+    config = SchedConfig()
+    lib.sched_default_config(ctypes.byref(config))
+    config.algorithm = lib.sched_parse_algorithm(algorithm.encode())
+    config.cpu_count = cpus
+    if algorithm in ('RR', 'MLFQ'):
+        config.time_quantum = quantum
+
+    results = SchedResults()
+    status = lib.sched_run(jobs, job_count, ctypes.byref(config), ctypes.byref(results))
+    lib.sched_free_jobs(jobs)
+    if status != 0:
+        print(f"{COLOR_RED}Error: sched_run rejected {algorithm} on {cpus} CPU(s){COLOR_RESET}")
+        return None
+
+    parsed: ResultsDict = {'process': [], 'cpu': [], 'average': []}
+    for i in range(results.process_count):
+        p = results.processes[i]
+        row = {'PID': str(p.pid), 'Arrival': str(p.arrival_time), 'Burst': str(p.burst_time),
+               'Priority': str(p.priority)}
+        stats = (p.start_time, p.finish_time, p.turnaround_time, p.waiting_time, p.response_time)
+        for col, value in zip(('Start', 'Finish', 'Turnaround', 'Waiting', 'Response'), stats):
+            row[col] = str(value) if p.completed else 'N/A'
+        parsed['process'].append(row)
+    for c in range(results.cpu_count):
+        cpu = results.cpus[c]
+        parsed['cpu'].append({'CPU_ID': str(cpu.id), 'BusyTime': str(cpu.busy_time),
+                              'IdleTime': str(cpu.idle_time), 'Utilization%': f"{cpu.utilization:.2f}"})
+    if results.completed_count > 0:
+        parsed['average'].append({'AvgTurnaround': f"{results.avg_turnaround:.2f}",
+                                  'AvgWaiting': f"{results.avg_waiting:.2f}",
+                                  'AvgResponse': f"{results.avg_response:.2f}"})
+    else:
+        parsed['average'].append({'AvgTurnaround': 'N/A', 'AvgWaiting': 'N/A', 'AvgResponse': 'N/A'})
+    lib.sched_free_results(ctypes.byref(results))
+    return parsed
+
+
 def parse_csv_section(output_lines: List[str], section_header: str) -> Optional[List[Dict[str, str]]]:
     """
     Parse a specific CSV section from the scheduler's output.
@@ -190,7 +306,8 @@ def parse_all_csv(output: str) -> Optional[ResultsDict]:
     """
     Parse all CSV sections from the scheduler's output.
     
-    Extracts the three main CSV sections: process stats, CPU stats, and average stats.
+    Extracts the three main CSV sections: process stats, CPU stats, and average stats,
+    plus the per-CPU overhead and affinity blocks when the run printed them.
     
     Args:
         output: The complete stdout text from the scheduler
@@ -207,6 +324,9 @@ def parse_all_csv(output: str) -> Optional[ResultsDict]:
     results['process'] = parse_csv_section(lines, 'Process Stats (CSV):')
     results['cpu'] = parse_csv_section(lines, 'CPU Stats (CSV):')
     results['average'] = parse_csv_section(lines, 'Average Stats (CSV):')
+    # Printed only when dispatch overhead or affinity is in play
+    results['overhead'] = parse_csv_section(lines, 'CPU Overhead Stats (CSV):') or []
+    results['affinity'] = parse_csv_section(lines, 'CPU Affinity Stats (CSV):') or []
 
     # Check if parsing failed for any section
     if results['process'] is None or results['cpu'] is None or results['average'] is None:
@@ -317,6 +437,25 @@ def compare_results(actual: ResultsDict, expected: ResultsDict) -> List[str]:
                         mismatches.append(f"CPU row {i+1}, Col '{col}': "
                                           f"Expected '{exp_row[col]}', Got '{act_row[col]}'")
 
+    # Compare the optional per-CPU blocks the expected results list
+    for section, title in (('overhead', 'Overhead'), ('affinity', 'Affinity')):
+        if section not in expected:
+            continue
+        if len(actual.get(section, [])) != len(expected[section]):
+            mismatches.append(f"{title} row count mismatch: Expected {len(expected[section])}, "
+                              f"Got {len(actual.get(section, []))}")
+            continue
+        for i, (act_row, exp_row) in enumerate(zip(actual[section], expected[section])):
+            for col, exp_val in exp_row.items():
+                if col not in act_row:
+                    mismatches.append(f"{title} row {i+1}: Missing column '{col}' in actual output")
+                    continue
+                same = compare_floats(act_row[col], exp_val, FLOAT_TOLERANCE) if col.endswith('%') \
+                    else compare_ints(act_row[col], exp_val)
+                if not same:
+                    mismatches.append(f"{title} row {i+1}, Col '{col}': "
+                                      f"Expected '{exp_val}', Got '{act_row[col]}'")
+
     # Compare Average Stats
     if len(actual.get('average', [])) != 1 or len(expected.get('average', [])) != 1:
         mismatches.append(f"Average stats row count mismatch: "
@@ -486,6 +625,26 @@ def create_test_files() -> Dict[str, str]:
         f.write("# PID Arrival Burst Priority\n")
         f.write("1 3 3 1\n")
 
+    # Out-of-order arrival that stream mode has to reject
+    test_files['stream_decreasing'] = 'test_processes_stream_decreasing.txt'
+    with open(test_files['stream_decreasing'], 'w') as f:
+        f.write("# PID Arrival Burst Priority\n")
+        f.write("1 0 3 1\n")
+        f.write("2 5 2 1\n")
+        f.write("3 2 1 1\n")  # Line 4: arrives before P2
+
+    # Checkpointed run and a copy whose last job changed; later checkpoints stay usable
+    test_files['resume_base'] = 'test_processes_resume_base.txt'
+    test_files['resume_edited'] = 'test_processes_resume_edited.txt'
+    for key, last_burst in (('resume_base', 2), ('resume_edited', 6)):
+        with open(test_files[key], 'w') as f:
+            f.write("# PID Arrival Burst Priority\n")
+            f.write("1 0 4 2\n")
+            f.write("2 1 3 1\n")
+            f.write("3 2 5 3\n")
+            f.write("4 12 3 2\n")
+            f.write(f"5 14 {last_burst} 1\n")
+    test_files['resume_checkpoint'] = 'test_checkpoint_resume.bin'  # Written by the check
 
     return test_files
 
@@ -972,11 +1131,236 @@ def define_test_cases(test_files: Dict[str, str]) -> List[TestCase]:
 
     ]
 
+    mlfq_tests = [
+        # MLFQ quantum 1/2/4: demoted jobs are preempted by new arrivals on level 0
+        (
+            "MLFQ_1CPU_Q1", "MLFQ", 1, 1, test_files['basic'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '5', 'Priority': '1', 'Start': '0', 'Finish': '9', 'Turnaround': '9', 'Waiting': '4', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '2', 'Burst': '3', 'Priority': '2', 'Start': '2', 'Finish': '7', 'Turnaround': '5', 'Waiting': '2', 'Response': '0'},
+                    {'PID': '3', 'Arrival': '4', 'Burst': '2', 'Priority': '1', 'Start': '4', 'Finish': '10', 'Turnaround': '6', 'Waiting': '4', 'Response': '0'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '10', 'IdleTime': '0', 'Utilization%': '100.00'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '6.67', 'AvgWaiting': '3.33', 'AvgResponse': '0.00'}
+                ]
+            }
+        ),
+    ]
+
+    prio_tests = [
+        # Non-preemptive priority: P1 keeps the CPU, then highest priority first
+        (
+            "PRIO_PRIORITY_INVERSION", "PRIO", 1, 0, test_files['priority_inversion'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '6', 'Priority': '1', 'Start': '0', 'Finish': '6', 'Turnaround': '6', 'Waiting': '0', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '1', 'Burst': '2', 'Priority': '5', 'Start': '6', 'Finish': '8', 'Turnaround': '7', 'Waiting': '5', 'Response': '5'},
+                    {'PID': '3', 'Arrival': '2', 'Burst': '3', 'Priority': '4', 'Start': '8', 'Finish': '11', 'Turnaround': '9', 'Waiting': '6', 'Response': '6'},
+                    {'PID': '4', 'Arrival': '3', 'Burst': '1', 'Priority': '3', 'Start': '11', 'Finish': '12', 'Turnaround': '9', 'Waiting': '8', 'Response': '8'},
+                    {'PID': '5', 'Arrival': '4', 'Burst': '2', 'Priority': '2', 'Start': '12', 'Finish': '14', 'Turnaround': '10', 'Waiting': '8', 'Response': '8'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '14', 'IdleTime': '0', 'Utilization%': '100.00'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '8.20', 'AvgWaiting': '5.40', 'AvgResponse': '5.40'}
+                ]
+            }
+        ),
+        # Preemptive priority: every arrival outranks the running job
+        (
+            "PPRIO_PRIORITY_INVERSION", "PPRIO", 1, 0, test_files['priority_inversion'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '6', 'Priority': '1', 'Start': '0', 'Finish': '14', 'Turnaround': '14', 'Waiting': '8', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '1', 'Burst': '2', 'Priority': '5', 'Start': '1', 'Finish': '3', 'Turnaround': '2', 'Waiting': '0', 'Response': '0'},
+                    {'PID': '3', 'Arrival': '2', 'Burst': '3', 'Priority': '4', 'Start': '3', 'Finish': '6', 'Turnaround': '4', 'Waiting': '1', 'Response': '1'},
+                    {'PID': '4', 'Arrival': '3', 'Burst': '1', 'Priority': '3', 'Start': '6', 'Finish': '7', 'Turnaround': '4', 'Waiting': '3', 'Response': '3'},
+                    {'PID': '5', 'Arrival': '4', 'Burst': '2', 'Priority': '2', 'Start': '7', 'Finish': '9', 'Turnaround': '5', 'Waiting': '3', 'Response': '3'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '14', 'IdleTime': '0', 'Utilization%': '100.00'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '5.80', 'AvgWaiting': '3.00', 'AvgResponse': '1.40'}
+                ]
+            }
+        ),
+    ]
+
+    # Dispatch overhead (--switch-cost / --migration-cost), derived by hand
+    overhead_tests = [
+        # RR q=2 with a 1-unit switch before every dispatch: P1 0-1 switch 1-3 run,
+        # P2 3-4/4-6, P1 6-7/7-9, P3 9-10/10-12 done, P2 12-13/13-14 done, P1 14-15/15-16 done.
+        # Start and response are the dispatch time, the quantum counts after the switch,
+        # and waiting leaves the switches out (P1: 16 - 5 burst - 3 switches = 8).
+        (
+            "RR_SWITCH_COST", "RR", 1, 2, test_files['basic'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '5', 'Priority': '1', 'Start': '0', 'Finish': '16', 'Turnaround': '16', 'Waiting': '8', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '2', 'Burst': '3', 'Priority': '2', 'Start': '3', 'Finish': '14', 'Turnaround': '12', 'Waiting': '7', 'Response': '1'},
+                    {'PID': '3', 'Arrival': '4', 'Burst': '2', 'Priority': '1', 'Start': '9', 'Finish': '12', 'Turnaround': '8', 'Waiting': '5', 'Response': '5'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '16', 'IdleTime': '0', 'Utilization%': '100.00'}
+                ],
+                'overhead': [
+                    {'CPU_ID': '0', 'OverheadTime': '6', 'Overhead%': '37.50'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '12.00', 'AvgWaiting': '6.67', 'AvgResponse': '2.00'}
+                ]
+            },
+            ['--switch-cost', '1']
+        ),
+    ]
+
+    # Same-CPU and migrated dispatch counts; a job's first dispatch is neither
+    affinity_tests = [
+        # RR q=1 on 2 CPUs, no affinity: t1 P3 -> CPU0, P1 -> CPU1 (migrated, 1-2 overhead);
+        # t2 P2 -> CPU0 (migrated, 2-3); t3 P1 stays on CPU1 (same); t4 P1 -> CPU0 (migrated, 4-5).
+        (
+            "RR_MIGRATION_COUNTS", "RR", 2, 1, test_files['few_procs_many_cpus'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '4', 'Priority': '1', 'Start': '0', 'Finish': '6', 'Turnaround': '6', 'Waiting': '0', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '0', 'Burst': '2', 'Priority': '2', 'Start': '0', 'Finish': '4', 'Turnaround': '4', 'Waiting': '1', 'Response': '0'},
+                    {'PID': '3', 'Arrival': '0', 'Burst': '1', 'Priority': '3', 'Start': '1', 'Finish': '2', 'Turnaround': '2', 'Waiting': '1', 'Response': '1'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '6', 'IdleTime': '0', 'Utilization%': '100.00'},
+                    {'CPU_ID': '1', 'BusyTime': '4', 'IdleTime': '2', 'Utilization%': '66.67'}
+                ],
+                'overhead': [
+                    {'CPU_ID': '0', 'OverheadTime': '2', 'Overhead%': '33.33'},
+                    {'CPU_ID': '1', 'OverheadTime': '1', 'Overhead%': '16.67'}
+                ],
+                'affinity': [
+                    {'CPU_ID': '0', 'SameCPUDispatches': '0', 'MigratedDispatches': '2'},
+                    {'CPU_ID': '1', 'SameCPUDispatches': '1', 'MigratedDispatches': '1'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '4.00', 'AvgWaiting': '0.67', 'AvgResponse': '0.33'}
+                ]
+            },
+            ['--migration-cost', '1']
+        ),
+        # Same workload with --affinity 0: P1 and P2 return to their CPUs after each
+        # quantum, and P3 waits for CPU1 to free up at t2.
+        (
+            "RR_AFFINITY_COUNTS", "RR", 2, 1, test_files['few_procs_many_cpus'],
+            {
+                'process': [
+                    {'PID': '1', 'Arrival': '0', 'Burst': '4', 'Priority': '1', 'Start': '0', 'Finish': '4', 'Turnaround': '4', 'Waiting': '0', 'Response': '0'},
+                    {'PID': '2', 'Arrival': '0', 'Burst': '2', 'Priority': '2', 'Start': '0', 'Finish': '2', 'Turnaround': '2', 'Waiting': '0', 'Response': '0'},
+                    {'PID': '3', 'Arrival': '0', 'Burst': '1', 'Priority': '3', 'Start': '2', 'Finish': '3', 'Turnaround': '3', 'Waiting': '2', 'Response': '2'}
+                ],
+                'cpu': [
+                    {'CPU_ID': '0', 'BusyTime': '4', 'IdleTime': '0', 'Utilization%': '100.00'},
+                    {'CPU_ID': '1', 'BusyTime': '3', 'IdleTime': '1', 'Utilization%': '75.00'}
+                ],
+                'affinity': [
+                    {'CPU_ID': '0', 'SameCPUDispatches': '3', 'MigratedDispatches': '0'},
+                    {'CPU_ID': '1', 'SameCPUDispatches': '1', 'MigratedDispatches': '0'}
+                ],
+                'average': [
+                    {'AvgTurnaround': '3.00', 'AvgWaiting': '0.67', 'AvgResponse': '0.67'}
+                ]
+            },
+            ['--affinity', '0']
+        ),
+    ]
+
     # Combine all tests
-    return fcfs_tests + sjf_tests + srtf_tests + rr_tests
+    return fcfs_tests + sjf_tests + srtf_tests + rr_tests + mlfq_tests + prio_tests + overhead_tests + affinity_tests
+
+
+# --- Command-Line Checks ---
+
+def run_command(cmd: List[str], stdin_file: Optional[str] = None) -> Optional[subprocess.CompletedProcess]:
+    """Run the scheduler without requiring success; None if it could not run."""
+    print(f"Running: {' '.join(cmd)}" + (f" < {stdin_file}" if stdin_file else ""))
+    try:
+        if stdin_file:
+            with open(stdin_file) as f:
+                return subprocess.run(cmd, stdin=f, capture_output=True, text=True, timeout=DEFAULT_TIMEOUT)
+        return subprocess.run(cmd, capture_output=True, text=True, timeout=DEFAULT_TIMEOUT)
+    except (FileNotFoundError, subprocess.TimeoutExpired) as e:
+        print(f"{COLOR_RED}Error running scheduler: {e}{COLOR_RESET}")
+        return None
+
+
+def check_stream_rejects_decreasing(executable: str, test_files: Dict[str, str]) -> List[str]:
+    """Stream mode (stdin and --stream) must stop with an error at a decreasing arrival."""
+    mismatches = []
+    path = test_files['stream_decreasing']
+    for cmd, stdin_file in (([executable, '-f', '-', '-a', 'FCFS'], path),
+                            ([executable, '-f', path, '--stream', '-a', 'FCFS'], None)):
+        result = run_command(cmd, stdin_file)
+        if result is None:
+            mismatches.append(f"'{' '.join(cmd)}' did not run")
+        elif result.returncode == 0:
+            mismatches.append(f"'{' '.join(cmd)}' accepted a decreasing arrival")
+        elif 'line 4' not in result.stderr or 'non-decreasing' not in result.stderr:
+            mismatches.append(f"'{' '.join(cmd)}' gave an unexpected error: {result.stderr.strip()!r}")
+    return mismatches
+
+
+def check_resume_matches_fresh(executable: str, test_files: Dict[str, str]) -> List[str]:
+    """--resume from a checkpoint of the unedited workload must match a run from scratch."""
+    checkpoint = test_files['resume_checkpoint']
+    common = ['-a', 'RR', '-c', '2', '-q', '2']
+    base = run_command([executable, '-f', test_files['resume_base']] + common +
+                       ['--checkpoint', checkpoint, '--checkpoint-every', '5'])
+    fresh = run_command([executable, '-f', test_files['resume_edited']] + common)
+    resumed = run_command([executable, '-f', test_files['resume_edited']] + common + ['--resume', checkpoint])
+    if base is None or fresh is None or resumed is None:
+        return ["Scheduler execution error"]
+    if base.returncode != 0 or fresh.returncode != 0 or resumed.returncode != 0:
+        return [f"Nonzero exit: checkpoint {base.returncode}, fresh {fresh.returncode}, resume {resumed.returncode}"]
+
+    mismatches = []
+    if 'Resuming from the checkpoint' not in resumed.stdout:
+        mismatches.append("No checkpoint was used; the run started from scratch")
+    fresh_results = parse_all_csv(fresh.stdout)
+    resumed_results = parse_all_csv(resumed.stdout)
+    if fresh_results is None or resumed_results is None:
+        return mismatches + ["CSV parsing error"]
+    return mismatches + compare_results(resumed_results, fresh_results)
+
+
+def define_checks() -> List[CheckCase]:
+    """Checks of command-line behavior that a CSV table cannot express."""
+    return [
+        ("STREAM_REJECTS_DECREASING", "FCFS", check_stream_rejects_decreasing),
+        ("RESUME_MATCHES_FRESH", "RR", check_resume_matches_fresh),
+    ]
+
+
+def run_checks(executable_path: str, test_files: Dict[str, str], checks: List[CheckCase]) -> Tuple[int, int]:
+    """Run command-line checks and report results; returns (passed_count, total_count)."""
+    passed = 0
+    print(f"\n{COLOR_CYAN}--- Running {len(checks)} Command-Line Checks ---{COLOR_RESET}")
+    for name, _, check in checks:
+        print(f"\n{COLOR_YELLOW}--- Check: {name} ---{COLOR_RESET}")
+        mismatches = check(executable_path, test_files)
+        if not mismatches:
+            print(f"{COLOR_GREEN}{COLOR_BOLD}>>> TEST PASSED{COLOR_RESET}")
+            passed += 1
+        else:
+            print(f"{COLOR_RED}{COLOR_BOLD}>>> TEST FAILED{COLOR_RESET}")
+            for mismatch in mismatches:
+                print(f"  - {mismatch}")
+    return passed, len(checks)
 
 
-def run_tests(executable_path: str, tests: List[TestCase], verbose: bool = False) -> Tuple[int, int]:
+def run_tests(executable_path: str, tests: List[TestCase], verbose: bool = False,
+              lib: Optional[ctypes.CDLL] = None, extra_args: Optional[List[str]] = None) -> Tuple[int, int]:
     """
     Run multiple scheduler tests and report results.
     
@@ -984,6 +1368,8 @@ def run_tests(executable_path: str, tests: List[TestCase], verbose: bool = False
         executable_path: Path to the scheduler executable
         tests: List of test case tuples to run
         verbose: Whether to show detailed scheduler output
+        lib: Loaded libscheduler to run the cases in-process instead
+        extra_args: Flags added to every run (one of CASE_VARIANTS)
         
     Returns:
         Tuple containing (passed_count, total_count)
@@ -991,23 +1377,31 @@ def run_tests(executable_path: str, tests: List[TestCase], verbose: bool = False
     total_tests = len(tests)
     passed_tests = 0
 
-    print(f"{COLOR_CYAN}--- Running {total_tests} Test Cases ---{COLOR_RESET}")
+    variant = f" with {' '.join(extra_args)}" if extra_args else ""
+    print(f"{COLOR_CYAN}--- Running {total_tests} Test Cases{variant} ---{COLOR_RESET}")
 
-    for name, algo, cpus, quantum, infile, expected in tests:
+    for name, algo, cpus, quantum, infile, expected, *case_args in tests:
         print(f"\n{COLOR_YELLOW}--- Test: {name} ({algo}, {cpus} CPU(s), "
-              f"Q={quantum if algo=='RR' else 'N/A'}) ---{COLOR_RESET}")
+              f"Q={quantum if algo=='RR' else 'N/A'}){variant} ---{COLOR_RESET}")
+        run_args = (case_args[0] if case_args else []) + (extra_args or [])
 
-        # Run scheduler
-        output = run_scheduler(executable_path, algo, cpus, quantum, infile, verbose)
-        if output is None:
-            print(f"{COLOR_RED}>>> TEST FAILED (Scheduler execution error){COLOR_RESET}")
-            continue
+        if lib is not None:
+            actual_results = run_library(lib, algo, cpus, quantum, infile)
+            if actual_results is None:
+                print(f"{COLOR_RED}>>> TEST FAILED (Library error){COLOR_RESET}")
+                continue
+        else:
+            # Run scheduler
+            output = run_scheduler(executable_path, algo, cpus, quantum, infile, verbose, run_args)
+            if output is None:
+                print(f"{COLOR_RED}>>> TEST FAILED (Scheduler execution error){COLOR_RESET}")
+                continue
 
-        # Parse results
-        actual_results = parse_all_csv(output)
-        if actual_results is None:
-            print(f"{COLOR_RED}>>> TEST FAILED (CSV parsing error){COLOR_RESET}")
-            continue
+            # Parse results
+            actual_results = parse_all_csv(output)
+            if actual_results is None:
+                print(f"{COLOR_RED}>>> TEST FAILED (CSV parsing error){COLOR_RESET}")
+                continue
 
         # Compare results
         mismatches = compare_results(actual_results, expected)
@@ -1029,16 +1423,18 @@ def main() -> None:
     parser = argparse.ArgumentParser(description="Test harness for the CPU scheduler implementation.")
     parser.add_argument('--executable', default=SCHEDULER_EXECUTABLE,
                         help=f"Path to the scheduler executable (default: {SCHEDULER_EXECUTABLE})")
-    parser.add_argument('--algorithm', choices=['FCFS', 'SJF', 'SRTF', 'RR'], 
+    parser.add_argument('--algorithm', choices=['FCFS', 'SJF', 'SRTF', 'RR', 'MLFQ', 'PRIO', 'PPRIO'], 
                         help="Run only tests for specified algorithm")
     parser.add_argument('--test', help="Run only the specified test by name")
     parser.add_argument('--verbose', action='store_true', help="Show detailed scheduler output")
     parser.add_argument('--no-cleanup', action='store_true', help="Keep generated test files")
+    parser.add_argument('--library', help="Run the cases in-process through this libscheduler.so")
     args = parser.parse_args()
 
     executable_path = args.executable
+    lib = load_library(args.library) if args.library else None
 
-    if not os.path.exists(executable_path):
+    if lib is None and not os.path.exists(executable_path):
         print(f"{COLOR_RED}Error: Executable '{executable_path}' not found.{COLOR_RESET}")
         print("Please compile the C code (e.g., gcc scheduler.c -o scheduler -lm) or provide the correct path.")
         return
@@ -1046,25 +1442,40 @@ def main() -> None:
     # Create all test files
     test_files = create_test_files()
     
-    # Define all test cases
+    # Define all test cases; flagged cases and command-line checks need the executable
     all_tests = define_test_cases(test_files)
+    if lib is not None:
+        all_tests = [tc for tc in all_tests if len(tc) == 6]
+    checks_to_run = define_checks() if lib is None else []
     
     # Filter tests based on command line arguments
     tests_to_run = all_tests
     if args.algorithm:
         tests_to_run = [tc for tc in all_tests if tc[1] == args.algorithm]
-        if not tests_to_run:
+        checks_to_run = [cc for cc in checks_to_run if cc[1] == args.algorithm]
+        if not tests_to_run and not checks_to_run:
             print(f"{COLOR_RED}No tests found for algorithm '{args.algorithm}'{COLOR_RESET}")
             return
             
     if args.test:
         tests_to_run = [tc for tc in tests_to_run if tc[0] == args.test]
-        if not tests_to_run:
+        checks_to_run = [cc for cc in checks_to_run if cc[0] == args.test]
+        if not tests_to_run and not checks_to_run:
             print(f"{COLOR_RED}No test found with name '{args.test}'{COLOR_RESET}")
             return
     
-    # Run the filtered tests
-    passed, total = run_tests(executable_path, tests_to_run, args.verbose)
+    # Run the filtered tests, once per flag variant (the library has no flags)
+    passed = total = 0
+    for extra_args in (CASE_VARIANTS[:1] if lib is not None else CASE_VARIANTS):
+        if not tests_to_run:
+            break
+        variant_passed, variant_total = run_tests(executable_path, tests_to_run, args.verbose, lib, extra_args)
+        passed += variant_passed
+        total += variant_total
+    if checks_to_run:
+        checks_passed, checks_total = run_checks(executable_path, test_files, checks_to_run)
+        passed += checks_passed
+        total += checks_total
     
     # Print summary
     print(f"\n{COLOR_CYAN}--- Test Summary ---{COLOR_RESET}")